@@ -8,6 +8,24 @@
 #include <time.h>
 #include <iomanip>
 #include <cmath>
+#include <cstring>
+#include <string_view>
+#include <bit>
+#include <deque>
+#include <atomic>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define BIG_INTEGER_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define BIG_INTEGER_TARGET(x)
+#else
+#define BIG_INTEGER_TARGET(x) __attribute__((target(x)))
+#endif
+#elif defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
 
 
 //      КОНСТРУКТОРЫ
@@ -43,26 +61,56 @@ big_integer::big_integer(unsigned long long a) {
 }
 
 big_integer::big_integer(const char* ch) {
-	this->CheckSignAndWrite(ch);
+	this->CheckSignAndWrite(ch, ch + strlen(ch));
 }
 
 big_integer::big_integer(const std::string& s) {
-	this->CheckSignAndWrite(s.c_str());
+	this->CheckSignAndWrite(s.data(), s.data() + s.size());
+}
+
+big_integer::big_integer(const char* ch, int base) {
+	this->CheckSignAndWrite(ch, ch + strlen(ch), base);
+}
+
+big_integer::big_integer(const std::string& s, int base) {
+	this->CheckSignAndWrite(s.data(), s.data() + s.size(), base);
 }
 
 
+//	десятичные цифры, старшая первой
 big_integer::big_integer(const std::vector<int>& vec) {
-	if (vec.empty())
+	if (vec.empty()) {
 		v.push_back(0);
-	for (size_t i = vec.size() - 1; i != -1; --i)
-		v.push_back(vec[i]);
+		return;
+	}
+	std::string text;
+	for (int digit : vec)
+		text.push_back(static_cast<char>('0' + digit));
+	this->CheckSignAndWrite(text.data(), text.data() + text.size());
+}
+
+big_integer::big_integer(const big_integer& b): sign(b.sign), v(b.v) {}
+
+//	источник остается каноническим нулем; его буфер после переноса
+//	встроенный, так что запись лимба не выделяет память
+big_integer::big_integer(big_integer&& b) noexcept: sign(b.sign), v(std::move(b.v)) {
+	b.sign = true;
+	b.v.clear();
+	b.v.push_back(0);
+}
+
+//	копия лимбов, на которые смотрит view, со знаком самого view
+big_integer::big_integer(big_integer_view b): sign(b.getSign() || b.isZero()) {
+	v.assign(b.data(), b.data() + b.size());
 }
 
-big_integer::big_integer(const big_integer& b) {
-	sign = b.sign;
-	v.assign(b.v.begin(), b.v.end());
+//	лимбы в памяти ресурса r; копия с другим ресурсом выносит число из арены
+big_integer::big_integer(std::pmr::memory_resource* r): v(r) {
+	v.push_back(0);
 }
 
+big_integer::big_integer(const big_integer& b, std::pmr::memory_resource* r): sign(b.sign), v(b.v, r) {}
+
 big_integer::big_integer(double d) {
 	if (d == 0)
 		*this = 0;
@@ -108,18 +156,525 @@ big_integer operator"" _bigInt(unsigned long long a) {
 	return temp;
 }
 
-std::ostream& operator<<(std::ostream& out, const big_integer& b) {
-	b.CheckSignForOut(out);
-	for (size_t i = b.v.size() - 1; i != -1; --i) {
-		out << static_cast<int>(b.v[i]);
+//                                      ПРОИЗВОЛЬНОЕ ОСНОВАНИЕ
+//	Основания 2^k переводятся за один проход по битам лимбов. Остальные идут
+//	делением пополам: число делится на chunk^(2^k), половины переводятся
+//	рекурсивно, а короткие куски - делением на одно слово или схемой Горнера.
+//	Умножение и деление больших половин идут через NTT и Burnikel-Ziegler,
+//	так что перевод не квадратичный. Десятичный кусок - 16 цифр, их разбор
+//	и запись берут ядра из раздела ПЕРЕВОД ЦИФР
+namespace {
+	constexpr size_t RadixLeafLevel = 6;
+	constexpr size_t RadixReciprocalDepth = 1;
+	constexpr char LowerDigits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+	constexpr char UpperDigits[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+	constexpr size_t DecimalChunkDigits = 16;
+	constexpr size_t DecimalCachedLevels = 20;
+	constexpr uint64_t SmallPowers10[] = { 1, 10, 100, 1'000, 10'000, 100'000, 1'000'000,
+		10'000'000, 100'000'000, 1'000'000'000, 10'000'000'000, 100'000'000'000,
+		1'000'000'000'000, 10'000'000'000'000, 100'000'000'000'000, 1'000'000'000'000'000,
+		10'000'000'000'000'000, 100'000'000'000'000'000, 1'000'000'000'000'000'000,
+		10'000'000'000'000'000'000u };
+
+	//	значение цифры в основаниях до 36; 36 для прочих символов
+	int DigitValue(int c) {
+		if (c >= '0' && c <= '9')
+			return c - '0';
+		if (c >= 'a' && c <= 'z')
+			return c - 'a' + 10;
+		if (c >= 'A' && c <= 'Z')
+			return c - 'A' + 10;
+		return 36;
+	}
+
+	//	10^(2^i) для i < DecimalCachedLevels. У каждого потока свой кэш; числа
+	//	в нем живут в new_delete_resource, чтобы не ссылаться на память чужой
+	//	арены, а deque не двигает их при росте, так что ссылки остаются
+	//	действительными. Кэш ограничен: старшая степень - 2^19 цифр, вместе с
+	//	делителями это около полутора мегабайт на поток; большие степени считают
+	//	RadixTable и shift_decimal на время вызова
+	const big_integer& DecimalPower(size_t i) {
+		thread_local std::deque<big_integer> powers;
+		while (powers.size() <= i) {
+			big_integer next = powers.empty() ? big_integer(10) : powers.back();
+			if (!powers.empty())
+				next.square();
+			powers.emplace_back(next, std::pmr::new_delete_resource());
+		}
+		return powers[i];
+	}
+
+	//	делитель на 10^(2^i) с обратной величиной Барретта; кэшируется рядом
+	//	со степенями и тоже в new_delete_resource. Без build возвращает только
+	//	уже построенный делитель или nullptr
+	const big_integer::modulus_context* DecimalDivisor(size_t i, bool build) {
+		thread_local std::deque<big_integer::modulus_context> divisors;
+		if (!build && divisors.size() <= i)
+			return nullptr;
+		while (divisors.size() <= i) {
+			digit_resource_scope scope(std::pmr::new_delete_resource());
+			divisors.emplace_back(DecimalPower(divisors.size()));
+		}
+		return &divisors[i];
+	}
+
+	//	chunk = base^width: для 10 это 10^16, для прочих оснований - наибольшая
+	//	степень, помещающаяся в 64 бита; powers[i] = chunk^(2^i) считаются по
+	//	мере надобности, десятичные ниже DecimalCachedLevels берутся из кэша
+	//	потока, а выше живут в таблице. deque не двигает степени при росте, так
+	//	что ссылки живут вместе с таблицей
+	class RadixTable {
+	public:
+		explicit RadixTable(int b): base(b) {
+			if (base == 10) {
+				chunk = SmallPowers10[DecimalChunkDigits];
+				width = DecimalChunkDigits;
+				return;
+			}
+			while (chunk <= UINT64_MAX / base) {
+				chunk *= base;
+				++width;
+			}
+		}
+
+		const big_integer& power(size_t i) {
+			size_t first = this->LocalLevel();
+			if (i < first)
+				return DecimalPower(i + std::countr_zero(DecimalChunkDigits));
+			while (first + powers.size() <= i) {
+				//	первая своя степень - chunk или квадрат старшей из кэша
+				big_integer next = !powers.empty() ? powers.back()
+					: (first != 0) ? this->power(first - 1) : big_integer(chunk);
+				if (!powers.empty() || first != 0)
+					next.square();
+				powers.push_back(std::move(next));
+			}
+			return powers[i - first];
+		}
+
+		//	деление на powers[i] умножением на обратную величину. Обратная
+		//	стоит нескольких умножений, поэтому строится, только если build:
+		//	делителем пользуется много узлов или он уже есть в кэше
+		const big_integer::modulus_context* divisor(size_t i, bool build) {
+			size_t first = this->LocalLevel();
+			if (i < first)
+				return DecimalDivisor(i + std::countr_zero(DecimalChunkDigits), build);
+			if (!build && first + divisors.size() <= i)
+				return nullptr;
+			while (first + divisors.size() <= i)
+				divisors.emplace_back(this->power(first + divisors.size()));
+			return &divisors[i - first];
+		}
+
+		//	уровень, на котором chunk^(2^level) заведомо больше числа из bits бит
+		size_t level(size_t bits) const {
+			size_t chunkBits = std::bit_width(chunk) - 1;
+			size_t level = 0;
+			while ((chunkBits << level) < bits)
+				++level;
+			return level;
+		}
+
+		const int base;
+		uint64_t chunk = 1;
+		size_t width = 0;
+		size_t top = 0;
+
+	private:
+		//	первый уровень, который таблица хранит сама
+		size_t LocalLevel() const {
+			return (base == 10) ? DecimalCachedLevels - std::countr_zero(DecimalChunkDigits) : 0;
+		}
+
+		std::deque<big_integer> powers;
+		std::deque<big_integer::modulus_context> divisors;
+	};
+
+	void FormatChunks(const uint64_t*, size_t, char*);
+	void ParseChunks(const char*, size_t, uint64_t*);
+
+	//	value < chunk^(2^level). Без leading пишется ровно width * 2^level символов
+	//	с ведущими нулями; у самого старшего куска (leading) они отбрасываются
+	template<typename Sink>
+	void WriteRadix(Sink& sink, big_integer value, size_t level, RadixTable& table, const char* alphabet, bool leading) {
+		if (level <= RadixLeafLevel) {
+			uint64_t chunks[size_t(1) << RadixLeafLevel];
+			char text[64 << RadixLeafLevel];
+			size_t count = size_t(1) << level;
+			for (size_t i = count; i != 0; --i)
+				chunks[i - 1] = (value == 0) ? 0 : value.divmod_small(table.chunk);
+			size_t length = table.width * count;
+			if (table.base == 10)
+				FormatChunks(chunks, count, text);
+			else {
+				for (size_t i = 0; i < count; ++i) {
+					uint64_t rest = chunks[i];
+					for (size_t k = table.width; k != 0; --k) {
+						text[i * table.width + k - 1] = alphabet[rest % table.base];
+						rest /= table.base;
+					}
+				}
+			}
+			size_t first = 0;
+			if (leading)
+				while (first + 1 < length && text[first] == '0')
+					++first;
+			sink.text(text + first, length - first);
+			return;
+		}
+		const big_integer& power = table.power(level - 1);
+		if (leading && value < power) {
+			WriteRadix(sink, std::move(value), level - 1, table, alphabet, true);
+			return;
+		}
+		//	на верхнем уровне делитель нужен одному узлу, и обычное
+		//	деление дешевле построения обратной
+		const big_integer::modulus_context* divisor = table.divisor(level - 1, level + RadixReciprocalDepth <= table.top);
+		auto [high, low] = divisor ? divisor->divmod(value) : value.divmod(power);
+		WriteRadix(sink, std::move(high), level - 1, table, alphabet, leading);
+		WriteRadix(sink, std::move(low), level - 1, table, alphabet, false);
+	}
+
+	//	основание 2^bits: символы снимаются с лимбов от старшего бита
+	template<typename Sink>
+	void WriteBinaryRadix(Sink& sink, big_integer_view magnitude, unsigned bits, const char* alphabet) {
+		size_t total = 64 * (magnitude.size() - 1) + std::bit_width(magnitude[magnitude.size() - 1]);
+		size_t count = std::max<size_t>((total + bits - 1) / bits, 1);
+		uint64_t mask = (uint64_t(1) << bits) - 1;
+		char text[256];
+		size_t filled = 0;
+		for (size_t i = count; i != 0; --i) {
+			size_t position = (i - 1) * bits;
+			size_t index = position / 64;
+			unsigned offset = position % 64;
+			uint64_t digit = magnitude[index] >> offset;
+			if (offset + bits > 64 && index + 1 < magnitude.size())
+				digit |= magnitude[index + 1] << (64 - offset);
+			text[filled++] = alphabet[digit & mask];
+			if (filled == sizeof(text)) {
+				sink.text(text, filled);
+				filled = 0;
+			}
+		}
+		sink.text(text, filled);
+	}
+
+	//	цифры модуля без ведущих нулей
+	template<typename Sink>
+	void WriteMagnitude(Sink& sink, const big_integer& magnitude, int base, bool upper) {
+		const char* alphabet = upper ? UpperDigits : LowerDigits;
+		big_integer_view view = magnitude.view();
+		if (std::has_single_bit(static_cast<unsigned>(base))) {
+			WriteBinaryRadix(sink, view, std::countr_zero(static_cast<unsigned>(base)), alphabet);
+			return;
+		}
+		RadixTable table(base);
+		size_t bits = 64 * (view.size() - 1) + std::bit_width(view[view.size() - 1]);
+		table.top = table.level(bits);
+		WriteRadix(sink, magnitude.Abs(), table.top, table, alphabet, true);
+	}
+
+	//	count <= width * 2^level символов, старшая цифра первой
+	big_integer ReadRadix(const char* digits, size_t count, size_t level, RadixTable& table) {
+		if (level <= RadixLeafLevel) {
+			big_integer value;
+			size_t i = count % table.width;
+			if (i != 0) {
+				uint64_t chunk = 0;
+				for (size_t k = 0; k < i; ++k)
+					chunk = chunk * table.base + DigitValue(digits[k]);
+				value += chunk;
+			}
+			uint64_t chunks[size_t(1) << RadixLeafLevel];
+			size_t blocks = (count - i) / table.width;
+			if (table.base == 10)
+				ParseChunks(digits + i, blocks, chunks);
+			else {
+				for (size_t b = 0; b < blocks; ++b) {
+					uint64_t chunk = 0;
+					for (size_t k = 0; k < table.width; ++k)
+						chunk = chunk * table.base + DigitValue(digits[i + b * table.width + k]);
+					chunks[b] = chunk;
+				}
+			}
+			for (size_t b = 0; b < blocks; ++b) {
+				value *= table.chunk;
+				value += chunks[b];
+			}
+			return value;
+		}
+		size_t half = table.width << (level - 1);
+		if (count <= half)
+			return ReadRadix(digits, count, level - 1, table);
+		big_integer value = ReadRadix(digits, count - half, level - 1, table);
+		value *= table.power(level - 1);
+		value += ReadRadix(digits + count - half, half, level - 1, table);
+		return value;
+	}
+
+	//	модуль по count допустимым цифрам основания base, не степени двойки
+	big_integer ParseRadix(const char* digits, size_t count, int base) {
+		RadixTable table(base);
+		size_t level = 0;
+		while ((table.width << level) < count)
+			++level;
+		return ReadRadix(digits, count, level, table);
+	}
+}
+
+namespace {
+	//	символы копятся в буфере на стеке и уходят в поток блоками через write
+	class ChunkWriter {
+	public:
+		explicit ChunkWriter(std::ostream& o): out(o) {}
+
+		void put(char c) {
+			if (size == Capacity)
+				this->flush();
+			buffer[size++] = c;
+		}
+
+		void fill(char c, size_t n) {
+			for (; n != 0; --n)
+				this->put(c);
+		}
+
+		void text(const char* s, size_t count) {
+			while (count != 0) {
+				if (size == Capacity)
+					this->flush();
+				size_t n = std::min(count, Capacity - size);
+				memcpy(buffer + size, s, n);
+				size += n;
+				s += n;
+				count -= n;
+			}
+		}
+
+		void flush() {
+			out.write(buffer, size);
+			size = 0;
+		}
+
+	private:
+		static constexpr size_t Capacity = 256;
+		std::ostream& out;
+		char buffer[Capacity];
+		size_t size = 0;
+	};
+
+	//	тот же интерфейс поверх std::string
+	class StringWriter {
+	public:
+		explicit StringWriter(std::string& s): out(s) {}
+
+		void put(char c) { out.push_back(c); }
+		void fill(char c, size_t n) { out.append(n, c); }
+		void text(const char* s, size_t count) { out.append(s, count); }
+
+	private:
+		std::string& out;
+	};
+
+	//	и поверх [first, last) для to_chars: лишние символы отбрасываются
+	class ArrayWriter {
+	public:
+		ArrayWriter(char* f, char* l): pos(f), last(l) {}
+
+		void put(char c) { this->text(&c, 1); }
+
+		void text(const char* s, size_t count) {
+			if (static_cast<size_t>(last - pos) < count) {
+				overflow = true;
+				count = last - pos;
+			}
+			pos = std::copy(s, s + count, pos);
+		}
+
+		char* pos;
+		char* last;
+		bool overflow = false;
+	};
+
+	//	'+' или '-' перед цифрами; true для минуса
+	bool ReadSign(std::streambuf* buffer, std::ios_base::iostate& state) {
+		int c = buffer->sgetc();
+		if (c == std::char_traits<char>::eof()) {
+			state |= std::ios_base::eofbit;
+			return false;
+		}
+		if (c == '-' || c == '+')
+			buffer->sbumpc();
+		return c == '-';
+	}
+
+	//	цифры основания base до первого постороннего символа, который остается в
+	//	потоке; для 16 пропускается необязательный префикс 0x. Цифры копятся в
+	//	буфере на стеке блоками по width * 2^RadixLeafLevel, каждый полный блок
+	//	сразу переводится, а готовые блоки сливаются попарно, как разряды
+	//	двоичного счетчика: строки со всем числом нет, и разбор не квадратичный.
+	//	Возвращает число цифр; без цифр value становится нулем
+	size_t ReadRadixNumber(std::streambuf* buffer, int base, big_integer& value, std::ios_base::iostate& state) {
+		struct Part {
+			big_integer value;
+			size_t level;
+		};
+		RadixTable table(base);
+		const size_t block = table.width << RadixLeafLevel;
+		char digits[64 << RadixLeafLevel];
+		std::vector<Part> parts;
+		size_t filled = 0;
+		size_t total = 0;
+
+		int c = buffer->sgetc();
+		if (base == 16 && c == '0') {
+			c = buffer->snextc();
+			if (c == 'x' || c == 'X')
+				c = buffer->snextc();
+			else
+				digits[filled++] = '0';
+		}
+		for (; ; c = buffer->snextc()) {
+			if (c == std::char_traits<char>::eof()) {
+				state |= std::ios_base::eofbit;
+				break;
+			}
+			if (DigitValue(c) >= base)
+				break;
+			digits[filled++] = static_cast<char>(c);
+			if (filled < block)
+				continue;
+
+			//	2^level полных блоков весят chunk^(2^(RadixLeafLevel + level))
+			parts.push_back({ ReadRadix(digits, block, RadixLeafLevel, table), 0 });
+			while (parts.size() > 1 && parts[parts.size() - 2].level == parts.back().level) {
+				Part low = std::move(parts.back());
+				parts.pop_back();
+				Part& high = parts.back();
+				high.value *= table.power(RadixLeafLevel + high.level);
+				high.value += low.value;
+				++high.level;
+			}
+			total += filled;
+			filled = 0;
+		}
+
+		value = 0;
+		for (Part& part : parts) {
+			value *= table.power(RadixLeafLevel + part.level);
+			value += part.value;
+		}
+		if (filled != 0) {
+			big_integer scale = 1;
+			for (size_t i = filled / table.width; i != 0; --i)
+				scale *= table.chunk;
+			uint64_t rest = 1;
+			for (size_t i = filled % table.width; i != 0; --i)
+				rest *= base;
+			scale *= rest;
+			value *= scale;
+			value += ReadRadix(digits, filled, RadixLeafLevel, table);
+		}
+		return total + filled;
+	}
+
+	//	основание из basefield потока: hex и oct, остальное десятичное
+	int StreamBase(std::ios_base::fmtflags flags) {
+		switch (flags & std::ios_base::basefield) {
+		case std::ios_base::hex:
+			return 16;
+		case std::ios_base::oct:
+			return 8;
+		default:
+			return 10;
+		}
 	}
+
+	//	знак, prefix и length символов тела, которые пишет body; соблюдает width,
+	//	fill, showpos и adjustfield потока, internal-заполнение идет после
+	//	префикса; width сбрасывается
+	template<typename Body>
+	void WritePadded(std::ostream& out, bool negative, std::string_view prefix, size_t length, Body body) {
+		std::ostream::sentry guard(out);
+		if (!guard)
+			return;
+
+		std::ios_base::fmtflags adjust = out.flags() & std::ios_base::adjustfield;
+		char signChar = negative ? '-' : ((out.flags() & std::ios_base::showpos) ? '+' : '\0');
+		length += prefix.size() + ((signChar != '\0') ? 1 : 0);
+		size_t width = (out.width() > 0) ? static_cast<size_t>(out.width()) : 0;
+		size_t pad = (width > length) ? width - length : 0;
+		out.width(0);
+
+		ChunkWriter writer(out);
+		if (adjust != std::ios_base::left && adjust != std::ios_base::internal)
+			writer.fill(out.fill(), pad);
+		if (signChar != '\0')
+			writer.put(signChar);
+		writer.text(prefix.data(), prefix.size());
+		if (adjust == std::ios_base::internal)
+			writer.fill(out.fill(), pad);
+		body(writer);
+		if (adjust == std::ios_base::left)
+			writer.fill(out.fill(), pad);
+		writer.flush();
+	}
+}
+
+//	знак, целая часть и, если fraction не nullptr, точка и scale дробных
+//	цифр с ведущими нулями. Длина для width берется из DecimalSize, число не
+//	переводится дважды
+void big_integer::WriteNumber(std::ostream& out, bool negative, const big_integer& integer, const big_integer* fraction, size_t scale) {
+	size_t length = 0;
+	if (out.width() > 0) {
+		length = integer.DecimalSize();
+		if (fraction != nullptr)
+			length += 1 + std::max(scale, fraction->DecimalSize());
+	}
+	WritePadded(out, negative, {}, length, [&](ChunkWriter& writer) {
+		WriteMagnitude(writer, integer, 10, false);
+		if (fraction != nullptr) {
+			writer.put('.');
+			writer.fill('0', scale - std::min(scale, fraction->DecimalSize()));
+			WriteMagnitude(writer, *fraction, 10, false);
+		}
+	});
+}
+
+//	std::hex и std::oct переводят модуль, showbase добавляет 0x или 0
+//	к ненулевому числу, uppercase дает заглавные цифры и 0X
+std::ostream& operator<<(std::ostream& out, const big_integer& b) {
+	int base = StreamBase(out.flags());
+	bool upper = (out.flags() & std::ios_base::uppercase) != 0;
+	std::string_view prefix;
+	if (base != 10 && (out.flags() & std::ios_base::showbase) && !b.view().isZero())
+		prefix = (base == 8) ? "0" : (upper ? "0X" : "0x");
+	size_t length = 0;
+	if (out.width() > 0) {
+		unsigned bits = std::countr_zero(static_cast<unsigned>(base));
+		length = (base == 10) ? b.DecimalSize() : std::max<size_t>((b.BitSize() + bits - 1) / bits, 1);
+	}
+	WritePadded(out, !b.sign, prefix, length, [&](ChunkWriter& writer) {
+		WriteMagnitude(writer, b, base, upper);
+	});
 	return out;
 }
 
+//	знак и цифры основания из basefield до первой не цифры, которая остается
+//	в потоке; цифры переводятся блоками по мере чтения. Без цифр ставится
+//	failbit, а число становится нулем
 std::istream& operator>>(std::istream& in, big_integer& b) {
-	std::string temp;
-	in >> temp;
-	b = static_cast<big_integer>(temp);
+	std::istream::sentry guard(in);
+	if (!guard)
+		return in;
+
+	std::ios_base::iostate state = std::ios_base::goodbit;
+	std::streambuf* buffer = in.rdbuf();
+	bool negative = ReadSign(buffer, state);
+	if (ReadRadixNumber(buffer, StreamBase(in.flags()), b, state) == 0)
+		state |= std::ios_base::failbit;
+	b.sign = !negative || b.view().isZero();
+	in.setstate(state);
 	return in;
 }
 
@@ -151,37 +706,41 @@ big_integer operator+(const big_integer& a, const big_integer& b) {
 	return temp;
 }
 
+big_integer operator+(big_integer&& a, const big_integer& b) {
+	a += b;
+	return std::move(a);
+}
+
+big_integer operator+(const big_integer& a, big_integer&& b) {
+	b += a;
+	return std::move(b);
+}
+
+big_integer operator+(big_integer&& a, big_integer&& b) {
+	return std::move(a) + b;
+}
+
 big_integer& big_integer::operator+=(const big_integer& b) {
-	if (this->Abs() == b.Abs() && sign != b.sign) {
-		sign = true;
-		v.erase(v.begin() + 1, v.end());
-		v[0] = 0;
-		v.shrink_to_fit();
+	return *this += b.view();
+}
+
+big_integer& big_integer::operator+=(big_integer_view b) {
+	if (this->Aliases(b))
+		return *this += big_integer(b);
+
+	int compare = big_integer_view::compareMagnitude(*this, b);
+	if (compare == 0 && sign != b.getSign()) {
+		this->SetZero();
 		return *this;
 	}
 
-	if (sign == b.sign) {
-		sign = this->sign;
+	if (sign == b.getSign()) {
 		this->PredSummer(b);
 	}
 	else {
-		if (sign == false) {
-			if (this->Abs() < b.Abs())
-				sign = true;
-			else
-				sign = false;
-		}
-		else {
-			if (this->Abs() < b.Abs())
-				sign = false;
-			else
-				sign = true;
-		}
-		size_t countInsub = 0;
-		this->PredDestr(b, countInsub);
-		while (v.back() == 0 && v.size() > 1) {
-			v.pop_back();
-		}
+		if (compare < 0)
+			sign = b.getSign();
+		this->PredDestr(b, compare > 0);
 	}
 	return *this;
 }
@@ -192,149 +751,192 @@ big_integer operator-(const big_integer& a, const big_integer& b) {
 	return temp;
 }
 
+big_integer operator-(big_integer&& a, const big_integer& b) {
+	a -= b;
+	return std::move(a);
+}
+
 big_integer& big_integer::operator-=(const big_integer& b) {
+	return *this -= b.view();
+}
 
-	size_t countInsub = 0;
-	if (*this == b && sign == b.sign) {
-		sign = true;
-		v.erase(v.begin() + 1, v.end());
-		v[0] = 0;
-		v.shrink_to_fit();
+big_integer& big_integer::operator-=(big_integer_view b) {
+	if (this->Aliases(b))
+		return *this -= big_integer(b);
+
+	int compare = big_integer_view::compareMagnitude(*this, b);
+	if (compare == 0 && sign == b.getSign()) {
+		this->SetZero();
 		return *this;
 	}
-	if (sign == b.sign) {
-		if (sign == false) {
-			if (this->Abs() > b.Abs()) {
-				sign = false;
-			}
-			else {
-				sign = true;
-			}
-		}
-		else {
-			if (this->Abs() > b.Abs()) {
-				sign = true;
-			}
-			else {
-				sign = false;
-			}
-		}
-		this->PredDestr(b, countInsub);
-		while (v.back() == 0) {
-			v.pop_back();
-		}
+	if (sign == b.getSign()) {
+		if (compare < 0)
+			sign = !sign;
+		this->PredDestr(b, compare > 0);
 	}
 	else {
-		if (sign == false) {
-			sign = false;
-		}
-		else {
-			sign = true;
-		}
 		this->PredSummer(b);
 	}
 	return *this;
 }
 
-void big_integer::PredSummer(const big_integer& b) {
-	if (v.size() < b.v.size()) {
-		size_t InitialSize = v.size();
-		v.resize(b.v.size(), 0);
-		v.reserve(b.v.size() + 1);
-		this->Summer(v.size(), b.v.size(), b, true, InitialSize);
-	}
-	else
-	{
-		size_t InitialSize = b.v.size();
-		v.reserve(v.size() + 1);
-		this->Summer(b.v.size(), v.size(), b, false, InitialSize);
-	}
+//	|*this| += |b|: сложение лимбов с переносом, перенос из старшего дописывается
+void big_integer::PredSummer(big_integer_view b) {
+	if (v.size() < b.size())
+		v.resize(b.size(), 0);
+	limb flag = AddTo(v.data(), v.size(), b.data(), b.size());
+	if (flag != 0)
+		v.push_back(flag);
 }
 
-void big_integer::PredDestr(const big_integer& b, size_t& countInsub) {
-	if (this->v.size() >= b.v.size() && this->Abs() > b.Abs()) {
-		this->Destructer(b, b.v.size(), v.size(), countInsub, true);
+//	|*this| = ||*this| - |b||; thisBigger - модуль *this больше
+void big_integer::PredDestr(big_integer_view b, bool thisBigger) {
+	if (thisBigger) {
+		SubFrom(v.data(), v.size(), b.data(), b.size());
 	}
 	else {
-		v.resize(b.v.size());
-		this->Destructer(b, v.size(), b.v.size(), countInsub, false);
-		if (countInsub != b.v.size()) {
-			memcpy(&v[0] + countInsub, &b.v[0] + countInsub, (b.v.size() - countInsub));
+		v.resize(b.size(), 0);
+		limb borrow = 0;
+		for (size_t i = 0; i < b.size(); ++i) {
+			limb x = b[i], y = v[i];
+			limb d = x - y;
+			limb next = (x < y) || (d < borrow);
+			v[i] = d - borrow;
+			borrow = next;
 		}
 	}
+	this->TrimDigits();
 }
 
-void big_integer::Destructer(const big_integer& b, size_t a, size_t a2, size_t& count, bool bol) {
-	int flag = 0;
-	for (; count < a; ++count) {
-		this->HelperDestructer1(b, flag, count, bol);
-	}
-	for (; count < a2 && flag != 0; ++count) {
-		this->HelperDestructer2(b, flag, count, bol);
-	}
+//	представление указывает внутрь собственных лимбов: изменение v его испортит
+bool big_integer::Aliases(big_integer_view b) const {
+	return b.data() >= v.data() && b.data() < v.data() + v.size();
 }
 
-void big_integer::HelperDestructer1(const big_integer& b, int& flag, size_t& count, bool bol) {
-	if (bol == true) {
-		if (v[count] - flag < b.v[count]) {
-			v[count] = 10 + v[count] - flag - b.v[count];
-			flag = 1;
-		}
-		else {
-			v[count] = (v[count] - b.v[count] - flag);
-			flag = 0;
-		}
+void big_integer::SetZero() {
+	sign = true;
+	v.erase(v.begin() + 1, v.end());
+	v[0] = 0;
+	v.shrink_to_fit();
+}
+
+big_integer& big_integer::operator*=(const big_integer& b) {
+	if (this == &b)
+		return this->square();
+
+	sign = (sign == b.sign) ? true : false;
+	if (v.size() <= b.v.size()) {
+		this->Multiply(*this, b);
 	}
 	else {
-		if (b.v[count] - flag < v[count]) {
-			v[count] = 10 + b.v[count] - flag - v[count];
-			flag = 1;
-		}
-		else {
-			v[count] = b.v[count] - v[count] - flag;
-			flag = 0;
-		}
+		this->Multiply(b, *this);
 	}
+	return *this;
 }
 
-void big_integer::HelperDestructer2(const big_integer& b, int& flag, size_t& count, bool bol) {
-	if (bol == true) {
-		if (v[count] - flag < 0) {
-			v[count] = 9;
-			flag = 1;
-		}
-		else {
-			v[count] -= flag;
-			flag = 0;
+//	операнд, совпадающий с *this, сначала копируется: аккумулятор меняется на месте
+big_integer& big_integer::addmul(const big_integer& a, const big_integer& b) {
+	if (&a == this || &b == this)
+		return *this += a * b;
+	this->MulAccumulate(a.v.data(), a.v.size(), b.v.data(), b.v.size(), a.sign != b.sign);
+	return *this;
+}
+
+big_integer& big_integer::submul(const big_integer& a, const big_integer& b) {
+	if (&a == this || &b == this)
+		return *this -= a * b;
+	this->MulAccumulate(a.v.data(), a.v.size(), b.v.data(), b.v.size(), a.sign == b.sign);
+	return *this;
+}
+
+big_integer& big_integer::addmul_small(const big_integer& a, uint64_t m) {
+	if (&a == this)
+		return *this += a * m;
+	this->MulAccumulate(a.v.data(), a.v.size(), &m, 1, !a.sign);
+	return *this;
+}
+
+big_integer& big_integer::submul_small(const big_integer& a, uint64_t m) {
+	if (&a == this)
+		return *this -= a * m;
+	this->MulAccumulate(a.v.data(), a.v.size(), &m, 1, a.sign);
+	return *this;
+}
+
+//	*this += (negative ? -1 : 1) * x * y. Короткий множитель идет строками
+//	AddMul1/SubMul1 прямо по лимбам числа, длинный - через MulLimbs.
+//	Если модуль вычитаемого больше, заем уходит за старший лимб ровно один раз,
+//	и результат переводится из дополнения до 2^(64n) с обращением знака
+void big_integer::MulAccumulate(const limb* x, size_t nx, const limb* y, size_t ny, bool negative) {
+	if (nx < ny) {
+		std::swap(x, y);
+		std::swap(nx, ny);
+	}
+	if ((nx == 1 && x[0] == 0) || (ny == 1 && y[0] == 0))
+		return;
+	bool accSign = (v.size() == 1 && v[0] == 0) ? !negative : sign;
+	bool add = (accSign != negative);
+	size_t n = std::max(v.size(), nx + ny) + 1;
+	v.resize(n, 0);
+	limb* acc = v.data();
+
+	limb borrow = 0;
+	if (ny < KaratsubaThreshold) {
+		for (size_t i = 0; i < ny; ++i) {
+			if (add) {
+				limb flag = AddMul1(acc + i, x, nx, y[i]);
+				AddTo(acc + i + nx, n - i - nx, &flag, 1);
+			}
+			else {
+				limb flag = SubMul1(acc + i, x, nx, y[i]);
+				borrow |= SubFrom(acc + i + nx, n - i - nx, &flag, 1);
+			}
 		}
 	}
 	else {
-		if (b.v[count] - flag < 0) {
-			v[count] = 9;
-			flag = 1;
-		}
-		else {
-			v[count] = (b.v[count] - flag);
-			flag = 0;
-		}
+		limbs product(nx + ny);
+		MulLimbs(x, nx, y, ny, product.data());
+		if (add)
+			AddTo(acc, n, product.data(), product.size());
+		else
+			borrow = SubFrom(acc, n, product.data(), product.size());
 	}
-}
 
-big_integer& big_integer::operator*=(const big_integer& b) {
-	sign = (sign == b.sign) ? true : false;
-	if (v.size() <= b.v.size()) {
-		this->Multiply(*this, b);
-	}
-	else {
-		this->Multiply(b, *this);
+	if (borrow != 0) {
+		for (size_t i = 0; i < n; ++i)
+			acc[i] = ~acc[i];
+		limb one = 1;
+		AddTo(acc, n, &one, 1);
+		accSign = !accSign;
 	}
+	this->TrimDigits();
+	sign = (v.back() != 0) ? accSign : true;
+}
+
+big_integer& big_integer::square() {
+	sign = true;
+	this->Multiply(*this, *this);
 	return *this;
 }
 
 big_integer& big_integer::operator=(const big_integer& other) {
 	if (this == &other)
 		return *this;
-	swap(other);
+	sign = other.sign;
+	v = other.v;
+	return *this;
+}
+
+//	v сохраняет свой ресурс: буфер источника забирается только при равных
+//	ресурсах; источник остается нулем во встроенном буфере
+big_integer& big_integer::operator=(big_integer&& other) {
+	if (this == &other)
+		return *this;
+	sign = other.sign;
+	v = std::move(other.v);
+	other.sign = true;
+	other.v.clear();
+	other.v.push_back(0);
 	return *this;
 }
 
@@ -345,187 +947,110 @@ big_integer operator*(const big_integer& a, const big_integer& b) {
 	return temp;
 }
 
+big_integer operator*(big_integer&& a, const big_integer& b) {
+	a *= b;
+	return std::move(a);
+}
 
-big_integer& big_integer::operator/=(const big_integer& b) {
-	if (b == 0)
-		throw std::invalid_argument("devision by zero");
+big_integer operator*(const big_integer& a, big_integer&& b) {
+	b *= a;
+	return std::move(b);
+}
 
-	int ans = 0;
-	bool tempSign = (sign != b.sign) ? false : true;
-	std::vector<int> delim;
-	std::vector<int> answer;
-	big_integer temp = b.Abs();
-	big_integer temp2 = this->Abs();
+big_integer operator*(big_integer&& a, big_integer&& b) {
+	return std::move(a) * b;
+}
 
-	if (temp == 1) {
-		sign = tempSign;
-		return *this;
-	}
-	
-	if (temp2 < temp) {
-		sign = tempSign;
-		*this = 0;
-		return *this;
-	}
-	else if (temp2 == temp) {
-		*this = static_cast<big_integer>(1);
-		sign = tempSign;
-		return *this;
-	}
 
-	big_integer del(delim);
-	if (temp2 <= 2147483647) {
-		*this = static_cast<int>(temp2) / static_cast<int>(temp);
-		sign = tempSign;
-		return *this;
-	}
-	else {
-		for (int i = v.size() - 1; i != -1;) 
-		{
-			while (i != -1 && del < temp) 
-			{
-				delim.push_back(temp2.v[i--]);
-				del = delim;
-				if (del < temp && i > 0 && i < v.size() - b.v.size())
-					answer.push_back(0);
-			}
-			while (del >= temp) 
-			{
-				del -= temp;
-				++ans;
-			}
-			answer.push_back(ans);
-			while (i > 0 && temp2.v[i] == 0 && del == 0)
-			{
-				answer.push_back(0);
-				--i;
-			}
-			ans = 0;
-			delim.clear();
-			if (del != 0) 
-			{
-				for (int i = del.v.size() - 1; i != -1 ; --i)
-					delim.push_back(del.v[i]);
-			}
-		}
-		*this = answer;
-		sign = tempSign;
-		return *this;
-	}
+big_integer& big_integer::operator/=(const big_integer& b) {
+	this->DivMod(b, this, nullptr);
+	return *this;
 }
 
 big_integer operator/(const big_integer& a, const big_integer& b) {
-	big_integer temp = a;
-	temp /= b;
-	return temp;
+	big_integer q;
+	a.DivMod(b, &q, nullptr);
+	return q;
 }
 
-big_integer& big_integer::operator%=(const big_integer& b) 
+big_integer& big_integer::operator%=(const big_integer& b)
 {
-	bool tempSign = sign;
-	if (b == 0)
-		throw std::invalid_argument("division by zero");
+	this->DivMod(b, nullptr, this);
+	return *this;
+}
 
-	std::vector<int> delim;
-	big_integer temp = b.Abs();
-	big_integer temp2 = this->Abs();
-	
-	if (temp2 == temp) {
-		*this = 0;
-		return *this;
-	}
+big_integer operator%(const big_integer& a, const big_integer& b) {
+	big_integer r;
+	a.DivMod(b, nullptr, &r);
+	return r;
+}
 
-	if (temp2 < temp) {
-		return *this;
-	}
-	
-	big_integer del(delim);
-		for (int i = temp2.v.size() - 1; i != -1;)
-		{
-			while (i != -1 && del < temp)
-			{
-				delim.push_back(temp2.v[i--]);
-				del = delim;
-			}
-			while (del >= temp)
-			{
-				del -= temp;
-			}
-			while (i > 0 && temp2.v[i] == 0 && del == 0)
-			{
-				--i;
-			}
-			delim.clear();
-			if (del != 0)
-			{
-				for (int i = del.v.size() - 1; i != -1; --i)
-					delim.push_back(del.v[i]);
-			}
-		}
-		*this = del;
-		sign = (*this != 0) ? tempSign : true;
-		return *this;
+//	одно деление на частное и остаток; частное округляется к нулю,
+//	остаток берет знак делимого. q и r могут совпадать с *this или b
+void big_integer::divmod(const big_integer& b, big_integer& q, big_integer& r) const {
+	this->DivMod(b, &q, &r);
 }
 
-big_integer operator%(const big_integer& a, const big_integer& b) {
-	big_integer temp = a;
-	temp %= b;
-	return temp;
+std::pair<big_integer, big_integer> big_integer::divmod(const big_integer& b) const {
+	std::pair<big_integer, big_integer> ans;
+	this->divmod(b, ans.first, ans.second);
+	return ans;
 }
 
-bool operator>(const big_integer& a, const big_integer& b) {
-	if (a == b)
-		return false;
+//	нулевой q или r не записывается, так что / и % не строят лишнее число
+void big_integer::DivMod(const big_integer& b, big_integer* q, big_integer* r) const {
+	if (b == 0)
+		throw std::invalid_argument("division by zero");
+
+	if (this->DivModInline(b, q, r))
+		return;
 
-	return !(a < b);
+	bool qSign = (sign == b.sign);
+	bool rSign = sign;
+	limbs x, y;
+	DivModLimbs(this->ToLimbs(), b.ToLimbs(), x, y);
+	if (q != nullptr)
+		q->AssignLimbs(x, qSign);
+	if (r != nullptr)
+		r->AssignLimbs(y, rSign);
+}
+
+bool operator>(const big_integer& a, const big_integer& b) {
+	return (a <=> b) > 0;
 }
 
 bool operator>=(const big_integer& a, const big_integer& b) {
-	return (b < a || b == a);
+	return (a <=> b) >= 0;
 }
 
 bool operator<(const big_integer& a, const big_integer& b) {
-	if (a.sign < b.sign)
-		return true;
-	if ((a.sign > b.sign) || (a.v.size() > b.v.size() && a.sign == true) || (a.v.size() < b.v.size() && (a.sign == false && b.sign == false))) {
-		return false;
-	}
-	if (a.v.size() != b.v.size())
-		return true;
-	else if (a.sign == true) {
-		return a.HelperForOperatorLowandBig(b, a);
-	}
-	else {
-		return a.HelperForOperatorLowandBig(a, b);
-	}
+	return (a <=> b) < 0;
 }
 
 bool operator<=(const big_integer& a, const big_integer& b) {
-	return (a < b || a == b);
+	return (a <=> b) <= 0;
 }
 
 bool operator==(const big_integer& a, const big_integer& b) {
-	if (a.sign == b.sign) {
-		return (a.v.size() != b.v.size()) ? false : a.HelperForMemcmp(a, b);
-	}
-	return false;
+	return (a <=> b) == 0;
 }
 
 bool operator!=(const big_integer& a, const big_integer& b) {
 	return !(a == b);
 }
 
+std::strong_ordering operator<=>(const big_integer& a, const big_integer& b) {
+	return a.view() <=> b.view();
+}
+
 big_integer::operator bool() const {
-	return (*this > static_cast<big_integer>(0)) ? true : false;
+	return sign && !this->view().isZero();
 }
 
 big_integer::operator int() const {
-	int ans = 0;
 	if (*this <= std::numeric_limits<int>::max() && *this >= std::numeric_limits<int>::min()) {
-		for (size_t i = v.size() - 1; i != -1; --i) {
-			ans = ans * 10 + v[i];
-		}
-		return (*this >= 0) ? ans : -ans;
+		int64_t ans = static_cast<int64_t>(v[0]);
+		return static_cast<int>((*this >= 0) ? ans : -ans);
 	}
 #define STRING2(x) #x
 #define STRING(x) STRING2(x)
@@ -534,218 +1059,1697 @@ big_integer::operator int() const {
 	return 0;
 }
 
+//	старшие 64 бита модуля с липким младшим битом: если отброшенные биты не
+//	нулевые, он выставляется, и округление к ближайшему не ошибается на половине
 big_integer::operator double() const {
 	if (this->Abs() > std::numeric_limits<double>::max())
 		throw std::invalid_argument("too match big_integer");
 
-	size_t count = 0;
-	double ans = 0.0;
-
-	if (v.size() > 16) {
-		count = v.size() - 16;
-		ans = v[v.size() - 16];
-
-		for (size_t i = v.size() - 15; i < v.size(); ++i) {
-			ans /= 10;
-			ans += v[i];
-		}
-
-		for (int i = 0; i < 14; ++i) {
-			ans *= 10;
-		}
-			
+	double ans;
+	size_t bits = this->BitSize();
+	if (bits <= 64) {
+		ans = static_cast<double>(v[0]);
 	}
 	else {
-		ans = v.front();
-		for (size_t i = 1; i < v.size(); ++i) {
-			ans /= 10;
-			ans += v[i];
-		}
-
-		for (int i = 0; i < v.size() - 1; ++i) {
-			ans *= 10;
+		size_t shift = bits - 64;
+		size_t index = shift / 64;
+		unsigned offset = shift % 64;
+		uint64_t top = v[index] >> offset;
+		bool sticky = false;
+		if (offset != 0) {
+			top |= v[index + 1] << (64 - offset);
+			sticky = (v[index] << (64 - offset)) != 0;
 		}
+		for (size_t i = 0; i < index && !sticky; ++i)
+			sticky = v[i] != 0;
+		ans = std::ldexp(static_cast<double>(top | (sticky ? 1 : 0)), static_cast<int>(shift));
 	}
 
 	return (*this >= 0) ? ans : -ans;
 }
 
-bool big_integer::HelperForMemcmp(const big_integer& a, const big_integer& b) const {
-	int temp = memcmp(a.to_string().c_str(), b.to_string().c_str(), b.to_string().size());
-	return (temp == 0) ? true : false;
-}
+namespace {
+	//	(high, low) = a * b
+	inline uint64_t MulWide(uint64_t a, uint64_t b, uint64_t& high) {
+#if defined(__SIZEOF_INT128__)
+		unsigned __int128 temp = static_cast<unsigned __int128>(a) * b;
+		high = static_cast<uint64_t>(temp >> 64);
+		return static_cast<uint64_t>(temp);
+#elif defined(_M_X64)
+		return _umul128(a, b, &high);
+#else
+		high = __umulh(a, b);
+		return a * b;
+#endif
+	}
+
+	//	(high * 2^64 + low) / d при high < d; остаток пишется в rest
+	inline uint64_t DivWide(uint64_t high, uint64_t low, uint64_t d, uint64_t& rest) {
+#if defined(__GNUC__) && defined(__x86_64__)
+		uint64_t q;
+		__asm__("divq %4" : "=a"(q), "=d"(rest) : "a"(low), "d"(high), "rm"(d));
+		return q;
+#elif defined(__SIZEOF_INT128__)
+		unsigned __int128 temp = (static_cast<unsigned __int128>(high) << 64) | low;
+		rest = static_cast<uint64_t>(temp % d);
+		return static_cast<uint64_t>(temp / d);
+#elif defined(_M_X64)
+		return _udiv128(high, low, d, &rest);
+#else
+		uint64_t q = 0;
+		for (int i = 63; i >= 0; --i) {
+			bool top = (high >> 63) != 0;
+			high = (high << 1) | (low >> 63);
+			low <<= 1;
+			q <<= 1;
+			if (top || high >= d) {
+				high -= d;
+				q |= 1;
+			}
+		}
+		rest = high;
+		return q;
+#endif
+	}
+
+	//	сумма и разность с переносом; на x86-64 - adc и sbb
+	inline unsigned char AddCarry(unsigned char c, uint64_t a, uint64_t b, uint64_t& out) {
+#ifdef BIG_INTEGER_X86
+		unsigned long long temp;
+		c = _addcarry_u64(c, a, b, &temp);
+		out = temp;
+		return c;
+#else
+		uint64_t s = a + b;
+		unsigned char flag = s < a;
+		out = s + c;
+		return flag | (out < s);
+#endif
+	}
+
+	inline unsigned char SubBorrow(unsigned char c, uint64_t a, uint64_t b, uint64_t& out) {
+#ifdef BIG_INTEGER_X86
+		unsigned long long temp;
+		c = _subborrow_u64(c, a, b, &temp);
+		out = temp;
+		return c;
+#else
+		uint64_t d = a - b;
+		unsigned char flag = a < b;
+		out = d - c;
+		return flag | (d < c);
+#endif
+	}
+}
+
+//                                      ПЕРЕВОД ЦИФР
+//	Строка хранит старшую цифру первой. Десятичный перевод идет кусками по 16
+//	цифр, каждый помещается в одно слово: разбор складывает цифры парами,
+//	четверками и восьмерками (pmaddubsw, pmaddwd), запись делит слово на
+//	восьмерки и четверки умножениями на обратные. На x86-64 разбор идет
+//	блоками по 16 (SSE4.1) или 32 (AVX2) байта, запись обходится SSE2,
+//	который есть всегда. Лучший набор выбирается один раз по cpuid,
+//	select_digit_kernels может переключить его на любой поддерживаемый
+namespace {
+	struct DigitKernels {
+		//	длина префикса из цифр '0'..'9'
+		size_t (*scan)(const char*, size_t);
+		//	blocks кусков по 16 цифр, старшая первой, в числа
+		void (*parse)(const char*, size_t, uint64_t*);
+		//	blocks чисел меньше 10^16 в куски по 16 цифр с ведущими нулями
+		void (*format)(const uint64_t*, size_t, char*);
+	};
+
+	size_t ScanDigitsScalar(const char* from, size_t n) {
+		size_t i = 0;
+		while (i < n && static_cast<unsigned char>(from[i] - '0') < 10)
+			++i;
+		return i;
+	}
+
+	void ParseDigitsScalar(const char* from, size_t blocks, uint64_t* out) {
+		for (size_t b = 0; b < blocks; ++b, from += 16) {
+			uint64_t value = 0;
+			for (size_t i = 0; i < 16; ++i)
+				value = value * 10 + static_cast<unsigned>(from[i] - '0');
+			out[b] = value;
+		}
+	}
+
+	void FormatDigitsScalar(const uint64_t* values, size_t blocks, char* to) {
+		for (size_t b = 0; b < blocks; ++b, to += 16) {
+			uint32_t half[2] = { static_cast<uint32_t>(values[b] / 100'000'000),
+				static_cast<uint32_t>(values[b] % 100'000'000) };
+			for (size_t h = 0; h < 2; ++h)
+				for (size_t i = 8; i != 0; --i) {
+					to[h * 8 + i - 1] = static_cast<char>('0' + half[h] % 10);
+					half[h] /= 10;
+				}
+		}
+	}
+
+#ifdef BIG_INTEGER_X86
+	//	младший нулевой бит маски - первая не цифра в блоке
+	size_t FirstClear(uint32_t mask) {
+		return std::countr_one(mask);
+	}
+
+	BIG_INTEGER_TARGET("sse4.1")
+	size_t ScanDigitsSse(const char* from, size_t n) {
+		const __m128i zero = _mm_set1_epi8('0');
+		const __m128i nine = _mm_set1_epi8(9);
+		size_t i = 0;
+		for (; i + 16 <= n; i += 16) {
+			__m128i d = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(from + i)), zero);
+			uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(d, nine), d));
+			if (mask != 0xFFFF)
+				return i + FirstClear(mask);
+		}
+		return i + ScanDigitsScalar(from + i, n - i);
+	}
+
+	//	16 цифр -> 8 пар -> 4 четверки -> 2 восьмерки -> одно слово
+	BIG_INTEGER_TARGET("sse4.1")
+	void ParseDigitsSse(const char* from, size_t blocks, uint64_t* out) {
+		const __m128i zero = _mm_set1_epi8('0');
+		const __m128i tens = _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1);
+		const __m128i hundreds = _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1);
+		const __m128i thousands = _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1);
+		for (size_t b = 0; b < blocks; ++b, from += 16) {
+			__m128i x = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(from)), zero);
+			x = _mm_maddubs_epi16(x, tens);
+			x = _mm_madd_epi16(x, hundreds);
+			x = _mm_packus_epi32(x, x);
+			x = _mm_madd_epi16(x, thousands);
+			uint64_t high = static_cast<uint32_t>(_mm_cvtsi128_si32(x));
+			uint64_t low = static_cast<uint32_t>(_mm_extract_epi32(x, 1));
+			out[b] = high * 100'000'000 + low;
+		}
+	}
+
+	//	хвост AVX2-ядер дописывается скалярно: переход в SSE-код без VEX
+	//	с грязными верхними половинами ymm стоит дороже самого хвоста
+	BIG_INTEGER_TARGET("avx2")
+	size_t ScanDigitsAvx2(const char* from, size_t n) {
+		const __m256i zero = _mm256_set1_epi8('0');
+		const __m256i nine = _mm256_set1_epi8(9);
+		size_t i = 0;
+		for (; i + 32 <= n; i += 32) {
+			__m256i d = _mm256_sub_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(from + i)), zero);
+			uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(d, nine), d));
+			if (mask != 0xFFFFFFFF)
+				return i + FirstClear(mask);
+		}
+		return i + ScanDigitsScalar(from + i, n - i);
+	}
+
+	//	два куска за раз, по одному в каждой 128-битной половине
+	BIG_INTEGER_TARGET("avx2")
+	void ParseDigitsAvx2(const char* from, size_t blocks, uint64_t* out) {
+		const __m256i zero = _mm256_set1_epi8('0');
+		const __m256i tens = _mm256_setr_epi8(
+			10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1,
+			10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1);
+		const __m256i hundreds = _mm256_setr_epi16(
+			100, 1, 100, 1, 100, 1, 100, 1, 100, 1, 100, 1, 100, 1, 100, 1);
+		const __m256i thousands = _mm256_setr_epi16(
+			10000, 1, 10000, 1, 10000, 1, 10000, 1, 10000, 1, 10000, 1, 10000, 1, 10000, 1);
+		size_t b = 0;
+		for (; b + 2 <= blocks; b += 2, from += 32) {
+			__m256i x = _mm256_sub_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(from)), zero);
+			x = _mm256_maddubs_epi16(x, tens);
+			x = _mm256_madd_epi16(x, hundreds);
+			x = _mm256_packus_epi32(x, x);
+			x = _mm256_madd_epi16(x, thousands);
+			out[b] = static_cast<uint64_t>(static_cast<uint32_t>(_mm256_extract_epi32(x, 0))) * 100'000'000
+				+ static_cast<uint32_t>(_mm256_extract_epi32(x, 1));
+			out[b + 1] = static_cast<uint64_t>(static_cast<uint32_t>(_mm256_extract_epi32(x, 4))) * 100'000'000
+				+ static_cast<uint32_t>(_mm256_extract_epi32(x, 5));
+		}
+		ParseDigitsScalar(from, blocks - b, out + b);
+	}
+
+	//	value < 10^8 -> восемь 16-битных цифр: деление на 10^4 и на 10^3..10^0
+	//	умножениями на обратные со сдвигом (схема Milo Yip из itoa-benchmark)
+	inline __m128i Convert8Digits(uint32_t value) {
+		const __m128i div10000 = _mm_set1_epi32(static_cast<int>(0xd1b71759));
+		const __m128i ten4 = _mm_set1_epi32(10000);
+		const __m128i divPowers = _mm_setr_epi16(8389, 5243, 13108, -32768, 8389, 5243, 13108, -32768);
+		const __m128i shiftPowers = _mm_setr_epi16(1 << 7, 1 << 11, 1 << 13, -32768, 1 << 7, 1 << 11, 1 << 13, -32768);
+		const __m128i ten = _mm_set1_epi16(10);
+
+		__m128i abcdefgh = _mm_cvtsi32_si128(static_cast<int>(value));
+		__m128i abcd = _mm_srli_epi64(_mm_mul_epu32(abcdefgh, div10000), 45);
+		__m128i efgh = _mm_sub_epi32(abcdefgh, _mm_mul_epu32(abcd, ten4));
+		__m128i v1 = _mm_slli_epi64(_mm_unpacklo_epi16(abcd, efgh), 2);
+		__m128i v2 = _mm_unpacklo_epi32(_mm_unpacklo_epi16(v1, v1), _mm_unpacklo_epi16(v1, v1));
+		__m128i v4 = _mm_mulhi_epu16(_mm_mulhi_epu16(v2, divPowers), shiftPowers);
+		__m128i v6 = _mm_slli_epi64(_mm_mullo_epi16(v4, ten), 16);
+		return _mm_sub_epi16(v4, v6);
+	}
+
+	void FormatDigitsSse2(const uint64_t* values, size_t blocks, char* to) {
+		const __m128i zero = _mm_set1_epi8('0');
+		for (size_t b = 0; b < blocks; ++b, to += 16) {
+			uint32_t high = static_cast<uint32_t>(values[b] / 100'000'000);
+			uint32_t low = static_cast<uint32_t>(values[b] % 100'000'000);
+			__m128i x = _mm_packus_epi16(Convert8Digits(high), Convert8Digits(low));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(to), _mm_add_epi8(x, zero));
+		}
+	}
+
+	struct CpuFeatures {
+		bool sse41;
+		bool avx2;
+	};
+
+	CpuFeatures DetectCpuFeatures() {
+#if defined(_MSC_VER) && !defined(__clang__)
+		int info[4];
+		__cpuid(info, 0);
+		int top = info[0];
+		__cpuid(info, 1);
+		bool sse41 = (info[2] >> 19) & 1;
+		bool avx2 = false;
+		if (top >= 7 && ((info[2] >> 27) & 1) && ((_xgetbv(0) & 6) == 6)) {
+			__cpuidex(info, 7, 0);
+			avx2 = (info[1] >> 5) & 1;
+		}
+		return { sse41, avx2 };
+#else
+		__builtin_cpu_init();
+		return { __builtin_cpu_supports("sse4.1") != 0, __builtin_cpu_supports("avx2") != 0 };
+#endif
+	}
+#endif
+
+	//	наборы в порядке big_integer::digit_kernels
+	const DigitKernels KernelSets[] = {
+		{ ScanDigitsScalar, ParseDigitsScalar, FormatDigitsScalar },
+#ifdef BIG_INTEGER_X86
+		{ ScanDigitsScalar, ParseDigitsScalar, FormatDigitsSse2 },
+		{ ScanDigitsSse, ParseDigitsSse, FormatDigitsSse2 },
+		{ ScanDigitsAvx2, ParseDigitsAvx2, FormatDigitsSse2 },
+#endif
+	};
+
+	bool SupportsDigitKernels(big_integer::digit_kernels set) {
+#ifdef BIG_INTEGER_X86
+		static const CpuFeatures cpu = DetectCpuFeatures();
+		switch (set) {
+		case big_integer::digit_kernels::scalar:
+		case big_integer::digit_kernels::sse2:
+			return true;
+		case big_integer::digit_kernels::sse41:
+			return cpu.sse41;
+		case big_integer::digit_kernels::avx2:
+			return cpu.avx2;
+		}
+		return false;
+#else
+		return set == big_integer::digit_kernels::scalar;
+#endif
+	}
+
+	std::atomic<big_integer::digit_kernels>& DigitKernelsChoice() {
+		static std::atomic<big_integer::digit_kernels> choice = [] {
+			for (auto set : { big_integer::digit_kernels::avx2, big_integer::digit_kernels::sse41, big_integer::digit_kernels::sse2 })
+				if (SupportsDigitKernels(set))
+					return set;
+			return big_integer::digit_kernels::scalar;
+		}();
+		return choice;
+	}
+
+	const DigitKernels& Digits() {
+		return KernelSets[static_cast<size_t>(DigitKernelsChoice().load(std::memory_order_relaxed))];
+	}
+
+	void FormatChunks(const uint64_t* values, size_t blocks, char* to) {
+		Digits().format(values, blocks, to);
+	}
+
+	void ParseChunks(const char* from, size_t blocks, uint64_t* out) {
+		Digits().parse(from, blocks, out);
+	}
+}
 
 //                                      МЕТОДЫ
+bool big_integer::select_digit_kernels(digit_kernels set) {
+	if (!SupportsDigitKernels(set))
+		return false;
+	DigitKernelsChoice().store(set, std::memory_order_relaxed);
+	return true;
+}
+
+big_integer::digit_kernels big_integer::current_digit_kernels() {
+	return DigitKernelsChoice().load(std::memory_order_relaxed);
+}
+
 std::string big_integer::to_string() const {
+	return this->to_string(10);
+}
+
+std::string big_integer::to_string(int base) const {
+	if (base < 2 || base > 36)
+		throw std::invalid_argument("invalid base");
 	std::string temp;
-	temp.reserve(v.size());
-	this->CheckSignForOut(temp);
-	this->HelperToString(temp);
+	if (!sign)
+		temp.push_back('-');
+	StringWriter writer(temp);
+	WriteMagnitude(writer, *this, base, false);
 	return temp;
 }
 
-void big_integer::HelperToString(std::string& temp) const {
-	size_t i = v.size() - 1;
-	while (i != 0 && v[i] == 0)
-		--i;
-	for (; i != -1; --i)
-		temp.push_back(static_cast<char>(v[i] + 48));
+//	делит модуль на d за один проход от старшего лимба: остаток с лимбом
+//	делится на d одним делением двойной ширины. Возвращает модуль остатка;
+//	знак остатка совпадает со знаком делимого
+uint64_t big_integer::divmod_small(uint64_t d) {
+	if (d == 0)
+		throw std::invalid_argument("division by zero");
+
+	uint64_t rest = 0;
+	for (size_t i = v.size(); i != 0; --i)
+		v[i - 1] = DivWide(rest, v[i - 1], d, rest);
+	this->TrimDigits();
+	if (v.back() == 0)
+		sign = true;
+	return rest;
 }
 
-void big_integer::CheckSignAndWrite(const char* ch) {
-	this->HelperForCheckSingAndWrite(ch, this->CheckSignForChar(ch));
+//	модуль остатка от деления модуля a на d тем же проходом, что и
+//	divmod_small, но без записи частного
+uint64_t big_integer::RemainderSmall(big_integer_view a, uint64_t d) {
+	uint64_t rest = 0;
+	for (size_t i = a.size(); i != 0; --i)
+		DivWide(rest, a[i - 1], d, rest);
+	return rest;
 }
 
-void big_integer::HelperForCheckSingAndWrite(const char* ch, int a) {
-	if (strlen(ch) > 1 && ch[1] == 0)
+std::strong_ordering big_integer::CompareSmall(big_integer_view a, uint64_t m, bool negative) {
+	limb d = m;
+	return a <=> big_integer_view(&d, 1, !negative);
+}
+
+//	*this += (negative ? -1 : 1) * m
+void big_integer::AddSmall(uint64_t m, bool negative) {
+	if (m == 0)
+		return;
+	if (sign != negative)
+		this->AddMagnitude(m);
+	else if (!this->SubMagnitude(m))
+		sign = !sign;
+	if (v.back() == 0)
 		sign = true;
-	try {
-		if (strlen(ch) == 0 || (strlen(ch) == 1 && a == 0))
-			throw std::invalid_argument("invalid argument");
+}
+
+void big_integer::MulSmall(uint64_t m, bool negative) {
+	if (m == 0) {
+		this->SetZero();
+		return;
 	}
-	catch(...) {
-		sign = true;
-		throw;
+	this->MulMagnitude(m);
+	if (negative)
+		this->NegateUnlessZero();
+}
+
+//	|*this| += m; перенос идет только до первого лимба, где он затух
+void big_integer::AddMagnitude(uint64_t m) {
+	if (AddTo(v.data(), v.size(), &m, 1) != 0)
+		v.push_back(1);
+}
+
+//	|*this| -= m, если |*this| >= m, иначе |*this| = m - |*this| и false.
+//	Знак не меняется, даже если модуль стал нулем
+bool big_integer::SubMagnitude(uint64_t m) {
+	if (v.size() == 1 && v[0] < m) {
+		v[0] = m - v[0];
+		return false;
 	}
+	SubFrom(v.data(), v.size(), &m, 1);
+	this->TrimDigits();
+	return true;
+}
+
+//	|*this| *= m для m != 0: лимб * m + перенос помещается в два слова,
+//	перенос из старшего дописывается новым лимбом
+void big_integer::MulMagnitude(uint64_t m) {
+	limb flag = 0;
+	for (size_t i = 0; i < v.size(); ++i) {
+		limb high;
+		limb low = MulWide(v[i], m, high);
+		low += flag;
+		high += low < flag;
+		v[i] = low;
+		flag = high;
+	}
+	if (flag != 0)
+		v.push_back(flag);
+}
+
+//	строка должна целиком быть числом; десятичное "-0..." исторически
+//	читается как неотрицательное число
+void big_integer::CheckSignAndWrite(const char* first, const char* last, int base) {
+	bool positiveZero = base == 10 && last - first > 1 && first[0] == '-' && first[1] == '0';
+	auto [ptr, ec] = big_integer::from_chars(first + positiveZero, last, *this, base);
+	if (ec == std::errc::not_enough_memory)
+		throw std::bad_alloc();
+	if (ec != std::errc() || ptr != last)
+		throw std::invalid_argument("invalid argument");
+}
+
+//	необязательный '-' и цифры основания base до первого постороннего символа
+//	(для оснований больше 10 буквы любого регистра, без префикса 0x).
+//	При ошибке value не меняется. Основание 2^k собирается в лимбы по k бит
+//	от младшей цифры, короткие числа прочих оснований - схемой Горнера,
+//	длинные идут через ParseRadix
+std::from_chars_result big_integer::from_chars(const char* first, const char* last, big_integer& value, int base) noexcept {
+	if (base < 2 || base > 36)
+		return { first, std::errc::invalid_argument };
+	bool negative = first != last && *first == '-';
+	const char* digits = first + negative;
+	const char* end = digits;
+	if (base == 10)
+		end += Digits().scan(digits, last - digits);
+	else
+		while (end != last && DigitValue(static_cast<unsigned char>(*end)) < base)
+			++end;
+	if (end == digits)
+		return { first, std::errc::invalid_argument };
+
+	//	число собирается в result с ресурсом value и меняется с value только
+	//	при успехе; пока оно в InlineCapacity лимбах, куча вообще не нужна
+	size_t count = end - digits;
 	try {
-		for (size_t i = strlen(ch) - 1; i != a; --i) {
-			if (static_cast<int>(ch[i]) < 48 || static_cast<int>(ch[i]) > 57)
-				throw std::invalid_argument("invalid argument");
-			v.push_back((static_cast<int>(ch[i]) - 48));
+		big_integer result(value.get_resource());
+		if (std::has_single_bit(static_cast<unsigned>(base))) {
+			unsigned bits = std::countr_zero(static_cast<unsigned>(base));
+			result.v.resize((count * bits + LimbBits - 1) / LimbBits, 0);
+			size_t position = 0;
+			for (const char* p = end; p != digits; position += bits) {
+				limb digit = DigitValue(static_cast<unsigned char>(*--p));
+				size_t index = position / LimbBits;
+				unsigned offset = position % LimbBits;
+				result.v[index] |= digit << offset;
+				if (offset + bits > LimbBits)
+					result.v[index + 1] |= digit >> (LimbBits - offset);
+			}
+			result.TrimDigits();
+		}
+		else if (RadixTable table(base); count <= (table.width << RadixLeafLevel)) {
+			//	не длиннее листа перевода: схема Горнера кусками по width цифр
+			//	прямо в лимбах результата
+			result.v.reserve(static_cast<size_t>(count * std::log2(base) / LimbBits) + 1);
+			const char* p = digits;
+			for (; p != digits + count % table.width; ++p)
+				result.v[0] = result.v[0] * base + DigitValue(static_cast<unsigned char>(*p));
+			for (; p != end; p += table.width) {
+				uint64_t chunk = 0;
+				if (base == 10)
+					Digits().parse(p, 1, &chunk);
+				else
+					for (size_t k = 0; k < table.width; ++k)
+						chunk = chunk * base + DigitValue(static_cast<unsigned char>(p[k]));
+				result.MulMagnitude(table.chunk);
+				result.AddMagnitude(chunk);
+			}
+			result.TrimDigits();
+		}
+		else {
+			result = ParseRadix(digits, count, base);
 		}
+		result.sign = !negative || result.v.back() == 0;
+		value.swap(result);
 	}
-	catch(...) {
-		v.clear();
-		v.shrink_to_fit();
-		v.push_back(0);
-		throw;
+	catch (...) {
+		return { first, std::errc::not_enough_memory };
 	}
+	return { end, std::errc() };
 }
 
-int big_integer::CheckSignForChar(const char* ch) {
-	if (strlen(ch) > 1 && ch[1] == '0' && ch[0] == '-') {
-		sign = true;
-		return 0;
+//	ведущие нули не пишутся; если места не хватает, возвращается
+//	value_too_large и содержимое [first, last) не определено
+std::to_chars_result big_integer::to_chars(char* first, char* last, const big_integer& value, int base) noexcept {
+	if (base < 2 || base > 36)
+		return { last, std::errc::invalid_argument };
+	ArrayWriter writer(first, last);
+	if (!value.sign)
+		writer.put('-');
+	try {
+		WriteMagnitude(writer, value, base, false);
 	}
-	if (ch[0] == '-') {
-		sign = false;
-		return 0;
+	catch (...) {
+		return { last, std::errc::not_enough_memory };
+	}
+	if (writer.overflow)
+		return { last, std::errc::value_too_large };
+	return { writer.pos, std::errc() };
+}
+
+//                                         ХРАНЕНИЕ ЦИФР
+digit_buffer::digit_buffer() noexcept: ptr(local), res(digit_resource_scope::current()) {}
+
+digit_buffer::digit_buffer(std::pmr::memory_resource* r) noexcept: ptr(local), res(r) {}
+
+digit_buffer::digit_buffer(const digit_buffer& other): ptr(local), res(digit_resource_scope::current()) {
+	this->assign(other.begin(), other.end());
+}
+
+digit_buffer::digit_buffer(const digit_buffer& other, std::pmr::memory_resource* r): ptr(local), res(r) {
+	this->assign(other.begin(), other.end());
+}
+
+//	встроенные лимбы копируются, буфер в куче забирается целиком вместе с ресурсом
+digit_buffer::digit_buffer(digit_buffer&& other) noexcept: ptr(local), count(other.count), res(other.res) {
+	if (other.isInline()) {
+		memcpy(local, other.local, count * sizeof(uint64_t));
+	}
+	else {
+		ptr = other.ptr;
+		cap = other.cap;
+		other.ptr = other.local;
+		other.cap = InlineCapacity;
+	}
+	other.count = 0;
+}
+
+digit_buffer& digit_buffer::operator=(const digit_buffer& other) {
+	if (this != &other)
+		this->assign(other.begin(), other.end());
+	return *this;
+}
+
+//	при разных ресурсах лимбы копируются в собственный буфер, поэтому
+//	присваивание может выделять память и не объявлено noexcept
+digit_buffer& digit_buffer::operator=(digit_buffer&& other) {
+	if (this == &other)
+		return *this;
+	if (!other.isInline() && *res != *other.res) {
+		this->assign(other.begin(), other.end());
+		return *this;
+	}
+	if (other.isInline()) {
+		memcpy(ptr, other.local, other.count * sizeof(uint64_t));
+		count = other.count;
+	}
+	else {
+		this->Release();
+		ptr = other.ptr;
+		count = other.count;
+		cap = other.cap;
+		other.ptr = other.local;
+		other.cap = InlineCapacity;
+	}
+	other.count = 0;
+	return *this;
+}
+
+digit_buffer::~digit_buffer() {
+	this->Release();
+}
+
+void digit_buffer::resize(size_t n, uint64_t value) {
+	if (n > count) {
+		this->reserve(n);
+		std::fill(ptr + count, ptr + n, value);
+	}
+	count = n;
+}
+
+void digit_buffer::reserve(size_t n) {
+	if (n > cap)
+		this->Grow(n);
+}
+
+//	возвращается во встроенный буфер, если лимбы там помещаются
+void digit_buffer::shrink_to_fit() {
+	if (this->isInline() || count > InlineCapacity)
+		return;
+	memcpy(local, ptr, count * sizeof(uint64_t));
+	this->Release();
+	ptr = local;
+	cap = InlineCapacity;
+}
+
+digit_buffer::iterator digit_buffer::insert(const_iterator pos, size_t n, uint64_t value) {
+	size_t index = pos - ptr;
+	this->reserve(count + n);
+	memmove(ptr + index + n, ptr + index, (count - index) * sizeof(uint64_t));
+	std::fill(ptr + index, ptr + index + n, value);
+	count += n;
+	return ptr + index;
+}
+
+digit_buffer::iterator digit_buffer::insert(const_iterator pos, const_iterator first, const_iterator last) {
+	if (first >= ptr && first < ptr + count) {
+		digit_buffer temp;
+		temp.assign(first, last);
+		return this->insert(pos, temp.begin(), temp.end());
+	}
+	size_t index = pos - ptr;
+	size_t n = last - first;
+	this->reserve(count + n);
+	memmove(ptr + index + n, ptr + index, (count - index) * sizeof(uint64_t));
+	memcpy(ptr + index, first, n * sizeof(uint64_t));
+	count += n;
+	return ptr + index;
+}
+
+digit_buffer::iterator digit_buffer::erase(const_iterator first, const_iterator last) {
+	size_t index = first - ptr;
+	size_t n = last - first;
+	memmove(ptr + index, ptr + index + n, (count - index - n) * sizeof(uint64_t));
+	count -= n;
+	return ptr + index;
+}
+
+void digit_buffer::assign(const_iterator first, const_iterator last) {
+	size_t n = last - first;
+	this->reserve(n);
+	memmove(ptr, first, n * sizeof(uint64_t));
+	count = n;
+}
+
+void digit_buffer::swap(digit_buffer& other) noexcept {
+	std::swap(res, other.res);
+	std::swap(cap, other.cap);
+	std::swap(count, other.count);
+	uint64_t temp[InlineCapacity];
+	bool thisInline = this->isInline(), otherInline = other.isInline();
+	memcpy(temp, local, sizeof(local));
+	memcpy(local, other.local, sizeof(local));
+	memcpy(other.local, temp, sizeof(local));
+	std::swap(ptr, other.ptr);
+	if (thisInline)
+		other.ptr = other.local;
+	if (otherInline)
+		ptr = local;
+}
+
+//	емкость растет вдвое, чтобы push_back оставался амортизированно O(1)
+void digit_buffer::Grow(size_t n) {
+	size_t newCap = std::max(n, cap * 2);
+	uint64_t* temp = static_cast<uint64_t*>(res->allocate(newCap * sizeof(uint64_t), alignof(uint64_t)));
+	memcpy(temp, ptr, count * sizeof(uint64_t));
+	this->Release();
+	ptr = temp;
+	cap = newCap;
+}
+
+void digit_buffer::Release() {
+	if (!this->isInline())
+		res->deallocate(ptr, cap * sizeof(uint64_t), alignof(uint64_t));
+}
+
+//                                         РЕСУРСЫ ПАМЯТИ
+digit_arena::digit_arena(size_t initialSize, std::pmr::memory_resource* upstream)
+	: std::pmr::monotonic_buffer_resource(initialSize, upstream) {}
+
+digit_pool_resource::digit_pool_resource(std::pmr::memory_resource* r): upstream(r) {}
+
+digit_pool_resource::~digit_pool_resource() {
+	this->release();
+}
+
+//	возвращает upstream все куски; блоки больше MaxBlock должны быть освобождены раньше
+void digit_pool_resource::release() {
+	while (chunks != nullptr) {
+		Chunk* next = chunks->next;
+		upstream->deallocate(chunks, chunks->size, BlockAlign);
+		chunks = next;
+	}
+	std::fill(freeLists, freeLists + ClassCount, nullptr);
+	cursor = limit = nullptr;
+}
+
+std::pmr::memory_resource* digit_pool_resource::upstream_resource() const {
+	return upstream;
+}
+
+//	номер класса: наименьшее k, при котором MinBlock * 2^k >= n
+size_t digit_pool_resource::SizeClass(size_t n) {
+	size_t k = 0;
+	for (size_t block = MinBlock; block < n; block *= 2)
+		++k;
+	return k;
+}
+
+void* digit_pool_resource::do_allocate(size_t n, size_t align) {
+	if (n > MaxBlock || align > BlockAlign)
+		return upstream->allocate(n, align);
+
+	size_t k = SizeClass(n);
+	if (freeLists[k] != nullptr) {
+		FreeBlock* block = freeLists[k];
+		freeLists[k] = block->next;
+		return block;
+	}
+
+	size_t block = MinBlock << k;
+	if (static_cast<size_t>(limit - cursor) < block) {
+		//	заголовок куска округлен до BlockAlign, чтобы блоки остались выровненными
+		size_t size = std::max(ChunkSize, block) + ChunkHeader;
+		Chunk* chunk = static_cast<Chunk*>(upstream->allocate(size, BlockAlign));
+		chunk->next = chunks;
+		chunk->size = size;
+		chunks = chunk;
+		cursor = reinterpret_cast<char*>(chunk) + ChunkHeader;
+		limit = reinterpret_cast<char*>(chunk) + size;
+	}
+	void* ans = cursor;
+	cursor += block;
+	return ans;
+}
+
+void digit_pool_resource::do_deallocate(void* p, size_t n, size_t align) {
+	if (n > MaxBlock || align > BlockAlign) {
+		upstream->deallocate(p, n, align);
+		return;
 	}
+	size_t k = SizeClass(n);
+	FreeBlock* block = static_cast<FreeBlock*>(p);
+	block->next = freeLists[k];
+	freeLists[k] = block;
+}
+
+bool digit_pool_resource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+	return this == &other;
+}
+
+namespace {
+	//	ресурс самой внутренней области потока; nullptr вне областей
+	thread_local std::pmr::memory_resource* currentDigitResource = nullptr;
+}
+
+digit_resource_scope::digit_resource_scope(std::pmr::memory_resource* r): previous(currentDigitResource) {
+	currentDigitResource = r;
+}
+
+digit_resource_scope::~digit_resource_scope() {
+	currentDigitResource = previous;
+}
+
+std::pmr::memory_resource* digit_resource_scope::current() noexcept {
+	return (currentDigitResource != nullptr) ? currentDigitResource : std::pmr::get_default_resource();
+}
+
+//                                         ПРЕДСТАВЛЕНИЕ БЕЗ ВЛАДЕНИЯ
+big_integer_view::big_integer_view(const big_integer& b): big_integer_view(b.view()) {}
+
+big_integer_view::big_integer_view(const uint64_t* ptr, size_t count, bool s): digits(ptr), length(count), sign(s) {}
+
+size_t big_integer_view::size() const {
+	return length;
+}
+
+uint64_t big_integer_view::operator[](size_t i) const {
+	return digits[i];
+}
+
+const uint64_t* big_integer_view::data() const {
+	return digits;
+}
+
+bool big_integer_view::getSign() const {
+	return sign;
+}
+
+bool big_integer_view::isZero() const {
+	return length == 1 && digits[0] == 0;
+}
+
+big_integer_view big_integer_view::abs() const {
+	return big_integer_view(digits, length, true);
+}
+
+big_integer_view big_integer_view::operator-() const {
+	return big_integer_view(digits, length, !sign);
+}
+
+bool operator==(big_integer_view a, big_integer_view b) {
+	return (a <=> b) == 0;
+}
+
+//	один проход без выделения памяти; знак нуля не учитывается
+std::strong_ordering operator<=>(big_integer_view a, big_integer_view b) {
+	int aSign = a.isZero() ? 0 : (a.sign ? 1 : -1);
+	int bSign = b.isZero() ? 0 : (b.sign ? 1 : -1);
+	if (aSign != bSign)
+		return aSign <=> bSign;
+
+	int temp = big_integer_view::compareMagnitude(a, b);
+	return (aSign >= 0) ? temp <=> 0 : 0 <=> temp;
+}
+
+int big_integer_view::compareMagnitude(big_integer_view a, big_integer_view b) {
+	if (a.length != b.length)
+		return (a.length < b.length) ? -1 : 1;
+	for (size_t count = a.length; count != 0; --count) {
+		if (a.digits[count - 1] != b.digits[count - 1])
+			return (a.digits[count - 1] < b.digits[count - 1]) ? -1 : 1;
+	}
+	return 0;
+}
+
+//	произведение модулей во временный вектор и обратно в v; совпадающие
+//	операнды MulLimbs узнает по адресу и возводит в квадрат
+void big_integer::Multiply(const big_integer& a, const big_integer& b) {
+	if (this->MultiplyInline(a, b))
+		return;
+
+	limbs temp(a.v.size() + b.v.size());
+	MulLimbs(a.v.data(), a.v.size(), b.v.data(), b.v.size(), temp.data());
+	this->AssignLimbs(temp, sign);
+}
+
+//	оба операнда во встроенных буферах: произведение на стеке, без обращений
+//	к куче (кроме роста v, если оно не помещается во встроенный буфер)
+bool big_integer::MultiplyInline(const big_integer& a, const big_integer& b) {
+	if (a.v.size() > digit_buffer::InlineCapacity || b.v.size() > digit_buffer::InlineCapacity)
+		return false;
+
+	limb temp[2 * digit_buffer::InlineCapacity];
+	size_t na = a.v.size(), nb = b.v.size();
+	if (&a == &b)
+		SqrSchoolbook(a.v.data(), na, temp);
 	else
-		return -1;
+		MulSchoolbook(a.v.data(), na, b.v.data(), nb, temp);
+	v.assign(temp, temp + na + nb);
+	this->TrimDigits();
+	if (v.back() == 0)
+		sign = true;
+	return true;
 }
 
-template<typename T>
-void big_integer::CheckSignForOut(T&) const {}
-template<>
-void big_integer::CheckSignForOut(std::string& s) const {
-	if (!sign)
-		s.push_back('-');
+//	делитель из одного лимба: деление на месте q одним проходом divmod_small,
+//	без q - во встроенной копии делимого
+bool big_integer::DivModInline(const big_integer& b, big_integer* q, big_integer* r) const {
+	if (b.v.size() != 1)
+		return false;
+
+	bool qSign = (sign == b.sign);
+	bool rSign = sign;
+	uint64_t y = b.v[0];
+	if (v.size() == 1) {
+		uint64_t x = v[0];
+		if (q != nullptr)
+			q->AssignSmall(x / y, qSign);
+		if (r != nullptr)
+			r->AssignSmall(x % y, rSign);
+		return true;
+	}
+	if (q == nullptr) {
+		r->AssignSmall(RemainderSmall(this->view(), y), rSign);
+		return true;
+	}
+
+	big_integer scratch;
+	big_integer& temp = (q != nullptr) ? *q : scratch;
+	if (&temp != this)
+		temp = *this;
+	uint64_t rest = temp.divmod_small(y);
+	temp.sign = temp.v.back() != 0 ? qSign : true;
+	if (r != nullptr)
+		r->AssignSmall(rest, rSign);
+	return true;
 }
-template<>
-void big_integer::CheckSignForOut(std::ostream& out) const {
-	if (sign == false)
-		out << '-';
+
+void big_integer::AssignLimbs(const limbs& a, bool newSign) {
+	if (a.empty()) {
+		this->AssignSmall(0, true);
+		return;
+	}
+	v.assign(a.data(), a.data() + a.size());
+	this->TrimDigits();
+	sign = (v.back() != 0) ? newSign : true;
 }
 
-void big_integer::Summer(size_t vectorSizeFor1, size_t vectorSizeFor2, const big_integer& b, bool Ifsmaller, size_t InitialSizeVector1) {
-	int flag = 0;
-	size_t countInsum = 0;
-	for (; countInsum < InitialSizeVector1; ++countInsum)
-	{
-		this->HelperForSummer(flag, countInsum, b.v[countInsum]);
+void big_integer::NegateUnlessZero() {
+	if (v.size() > 1 || v[0] != 0)
+		sign = !sign;
+}
+
+//	записывает модуль a на место текущих лимбов, переиспользуя их память
+void big_integer::AssignSmall(uint64_t a, bool newSign) {
+	v.clear();
+	v.push_back(a);
+	sign = (a != 0) ? newSign : true;
+}
+
+void big_integer::TrimDigits() {
+	while (v.size() > 1 && v.back() == 0)
+		v.pop_back();
+}
+
+//	копия лимбов во временную память ядер
+big_integer::limbs big_integer::ToLimbs() const {
+	return limbs(v.begin(), v.end());
+}
+
+//	out должен вмещать na + nb лимбов и не пересекаться с операндами
+void big_integer::MulSchoolbook(const limb* a, size_t na, const limb* b, size_t nb, limb* out) {
+	std::fill(out, out + na + nb, 0);
+	for (size_t i = 0; i < na; ++i)
+		out[i + nb] = AddMul1(out + i, b, nb, a[i]);
+}
+
+//	симметричный вариант: каждое произведение a[i] * a[k] при i < k считается
+//	один раз и удваивается, затем добавляются квадраты a[i]^2
+void big_integer::SqrSchoolbook(const limb* a, size_t n, limb* out) {
+	std::fill(out, out + 2 * n, 0);
+	for (size_t i = 0; i < n; ++i)
+		out[i + n] = AddMul1(out + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+	AddTo(out, 2 * n, out, 2 * n);
+
+	unsigned char flag = 0;
+	for (size_t i = 0; i < n; ++i) {
+		limb high;
+		limb low = MulWide(a[i], a[i], high);
+		flag = AddCarry(flag, out[2 * i], low, out[2 * i]);
+		flag = AddCarry(flag, out[2 * i + 1], high, out[2 * i + 1]);
+	}
+}
+
+//	выбирает алгоритм по размеру меньшего операнда; совпадающие операнды
+//	каждый уровень обрабатывает как возведение в квадрат
+void big_integer::MulLimbs(const limb* a, size_t na, const limb* b, size_t nb, limb* out) {
+	if (na < nb) {
+		std::swap(a, b);
+		std::swap(na, nb);
+	}
+	if (nb < KaratsubaThreshold && a == b && na == nb)
+		SqrSchoolbook(a, na, out);
+	else if (nb < KaratsubaThreshold)
+		MulSchoolbook(a, na, b, nb, out);
+	else if (nb >= NttThreshold && na + nb <= NttMaxSize)
+		MulNtt(a, na, b, nb, out);
+	else if (2 * nb <= na)
+		MulUnbalanced(a, na, b, nb, out);
+	else if (nb < Toom3Threshold || nb <= 2 * ((na + 2) / 3))
+		MulKaratsuba(a, na, b, nb, out);
+	else
+		MulToom3(a, na, b, nb, out);
+}
+
+//	na >= nb > (na + 1) / 2: a = a1 * B^m + a0, b = b1 * B^m + b0,
+//	a * b = z2 * B^2m + ((a0 + a1)(b0 + b1) - z0 - z2) * B^m + z0
+void big_integer::MulKaratsuba(const limb* a, size_t na, const limb* b, size_t nb, limb* out) {
+	size_t m = (na + 1) / 2;
+	size_t high = na + nb - 2 * m;
+
+	MulLimbs(a, m, b, m, out);
+	MulLimbs(a + m, na - m, b + m, nb - m, out + 2 * m);
+
+	limbs temp(4 * m + 4, 0);
+	limb* sa = temp.data();
+	limb* sb = sa + m + 1;
+	limb* z1 = sb + m + 1;
+	std::copy(a, a + m, sa);
+	sa[m] = AddTo(sa, m, a + m, na - m);
+	if (a == b && na == nb) {
+		sb = sa;
 	}
-	if (Ifsmaller == true)
-	{
-		for (; countInsum < vectorSizeFor2 && flag != 0; ++countInsum) {
-			this->HelperForSummer(flag, countInsum, b.v[countInsum]);
+	else {
+		std::copy(b, b + m, sb);
+		sb[m] = AddTo(sb, m, b + m, nb - m);
+	}
+	MulLimbs(sa, m + 1, sb, m + 1, z1);
+
+	SubFrom(z1, 2 * m + 2, out, 2 * m);
+	SubFrom(z1, 2 * m + 2, out + 2 * m, high);
+	size_t z1Size = std::min(2 * m + 2, na + nb - m);
+	AddTo(out + m, na + nb - m, z1, z1Size);
+}
+
+//	Toom-3 в точках 0, 1, -1, -2, бесконечность; интерполяция по схеме Бодрато.
+//	Требует nb > 2 * k, где k = ceil(na / 3), чтобы старший кусок b был непустым
+void big_integer::MulToom3(const limb* a, size_t na, const limb* b, size_t nb, limb* out) {
+	size_t k = (na + 2) / 3;
+
+	limbs p1, pm1, pm2, q1, qm1, qm2;
+	bool pm1Neg = false, pm2Neg = false, qm1Neg = false, qm2Neg = false;
+	ToomEvaluate(a, na, k, p1, pm1, pm1Neg, pm2, pm2Neg);
+
+	limbs r0(2 * k), rinf(na + nb - 4 * k);
+	MulLimbs(a, k, b, k, r0.data());
+	MulLimbs(a + 2 * k, na - 2 * k, b + 2 * k, nb - 2 * k, rinf.data());
+	Trim(r0);
+	Trim(rinf);
+
+	limbs r1, rm1, r3;
+	bool r1Neg = false, rm1Neg = false, r3Neg = false;
+	if (a == b && na == nb) {
+		//	один и тот же вектор в обоих операндах уходит в возведение в квадрат
+		MulSigned(p1, false, p1, false, r1, r1Neg);
+		MulSigned(pm1, false, pm1, false, rm1, rm1Neg);
+		MulSigned(pm2, false, pm2, false, r3, r3Neg);
+	}
+	else {
+		ToomEvaluate(b, nb, k, q1, qm1, qm1Neg, qm2, qm2Neg);
+		MulSigned(p1, false, q1, false, r1, r1Neg);
+		MulSigned(pm1, pm1Neg, qm1, qm1Neg, rm1, rm1Neg);
+		MulSigned(pm2, pm2Neg, qm2, qm2Neg, r3, r3Neg);
+	}
+
+	AddSigned(r3, r3Neg, r1, !r1Neg);
+	DivExact3(r3);
+	AddSigned(r1, r1Neg, rm1, !rm1Neg);
+	Halve(r1);
+	limbs r2 = rm1;
+	bool r2Neg = rm1Neg;
+	AddSigned(r2, r2Neg, r0, true);
+	limbs temp = r2;
+	bool tempNeg = r2Neg;
+	AddSigned(temp, tempNeg, r3, !r3Neg);
+	Halve(temp);
+	r3.swap(temp);
+	r3Neg = tempNeg;
+	AddSigned(r3, r3Neg, rinf, false);
+	AddSigned(r3, r3Neg, rinf, false);
+	AddSigned(r2, r2Neg, r1, r1Neg);
+	AddSigned(r2, r2Neg, rinf, true);
+	AddSigned(r1, r1Neg, r3, !r3Neg);
+
+	size_t n = na + nb;
+	std::fill(out, out + n, 0);
+	std::copy(r0.begin(), r0.end(), out);
+	std::copy(rinf.begin(), rinf.end(), out + 4 * k);
+	AddTo(out + k, n - k, r1.data(), r1.size());
+	AddTo(out + 2 * k, n - 2 * k, r2.data(), r2.size());
+	AddTo(out + 3 * k, n - 3 * k, r3.data(), r3.size());
+}
+
+//	свертка 32-битных половин лимбов по трем простым вида c * 2^k + 1
+//	с восстановлением по КТО (Гарнер). Коэффициент свертки не больше
+//	2^22 * (2^32)^2 < P1 * P2 * P3, поэтому длина na + nb ограничена
+//	NttMaxSize; длиннее разбивает Toom-3
+namespace {
+	constexpr uint32_t NttPrime1 = 998'244'353;
+	constexpr uint32_t NttPrime2 = 167'772'161;
+	constexpr uint32_t NttPrime3 = 469'762'049;
+	constexpr unsigned NttPieceBits = 32;
+	constexpr unsigned NttPieces = 64 / NttPieceBits;
+	constexpr uint64_t NttPieceMask = (uint64_t(1) << NttPieceBits) - 1;
+
+	template<uint32_t Mod>
+	uint32_t PowMod(uint64_t base, uint64_t exp) {
+		uint64_t ans = 1;
+		base %= Mod;
+		for (; exp != 0; exp >>= 1) {
+			if (exp & 1)
+				ans = ans * base % Mod;
+			base = base * base % Mod;
+		}
+		return static_cast<uint32_t>(ans);
+	}
+
+	//	блоки длиннее NttBlock делятся рекурсивно: после первого прохода
+	//	половины обрабатываются целиком, пока лежат в кэше
+	constexpr size_t NttBlock = size_t(1) << 14;
+
+	//	x < 2 * Mod < 2^31 -> x mod Mod; без ветвления, которое на случайных
+	//	вычетах предсказывается плохо
+	template<uint32_t Mod>
+	uint32_t ReduceOnce(uint32_t x) {
+		uint32_t r = x - Mod;
+		return r + (Mod & (0u - (r >> 31)));
+	}
+
+	//	один слой бабочек длины 2 * half по всем n элементам
+	template<uint32_t Mod>
+	void NttForwardPass(uint32_t* a, size_t n, size_t half, const uint32_t* roots) {
+		for (size_t i = 0; i < n; i += 2 * half) {
+			for (size_t k = 0; k < half; ++k) {
+				uint32_t x = a[i + k];
+				uint32_t y = a[i + k + half];
+				a[i + k] = ReduceOnce<Mod>(x + y);
+				//	x + Mod - y < 2^31: остаток снимает и лишний Mod
+				a[i + k + half] = static_cast<uint32_t>(static_cast<uint64_t>(x + Mod - y) * roots[half + k] % Mod);
+			}
+		}
+	}
+
+	template<uint32_t Mod>
+	void NttInversePass(uint32_t* a, size_t n, size_t half, const uint32_t* roots) {
+		for (size_t i = 0; i < n; i += 2 * half) {
+			for (size_t k = 0; k < half; ++k) {
+				uint32_t x = a[i + k];
+				uint32_t y = static_cast<uint32_t>(static_cast<uint64_t>(a[i + k + half]) * roots[half + k] % Mod);
+				a[i + k] = ReduceOnce<Mod>(x + y);
+				a[i + k + half] = ReduceOnce<Mod>(x + Mod - y);
+			}
 		}
-		if (flag == 0 && countInsum != b.v.size())
-			memcpy(&v[0] + countInsum, &b.v[countInsum], (b.v.size() - countInsum));
+	}
+
+	template<uint32_t Mod>
+	void NttForward(uint32_t* a, size_t n, const uint32_t* roots) {
+		if (n > NttBlock) {
+			NttForwardPass<Mod>(a, n, n / 2, roots);
+			NttForward<Mod>(a, n / 2, roots);
+			NttForward<Mod>(a + n / 2, n / 2, roots);
+			return;
+		}
+		for (size_t half = n / 2; half != 0; half >>= 1)
+			NttForwardPass<Mod>(a, n, half, roots);
+	}
+
+	template<uint32_t Mod>
+	void NttInverse(uint32_t* a, size_t n, const uint32_t* roots) {
+		if (n > NttBlock) {
+			NttInverse<Mod>(a, n / 2, roots);
+			NttInverse<Mod>(a + n / 2, n / 2, roots);
+			NttInversePass<Mod>(a, n, n / 2, roots);
+			return;
+		}
+		for (size_t half = 1; half < n; half <<= 1)
+			NttInversePass<Mod>(a, n, half, roots);
+	}
+}
+
+void big_integer::MulNtt(const limb* a, size_t na, const limb* b, size_t nb, limb* out) {
+	residues r1, r2, r3;
+	NttConvolution<NttPrime1>(a, na, b, nb, r1);
+	NttConvolution<NttPrime2>(a, na, b, nb, r2);
+	NttConvolution<NttPrime3>(a, na, b, nb, r3);
+
+	const uint64_t inv1 = PowMod<NttPrime2>(NttPrime1, NttPrime2 - 2);
+	const uint64_t inv12 = PowMod<NttPrime3>(static_cast<uint64_t>(NttPrime1) * NttPrime2 % NttPrime3, NttPrime3 - 2);
+	const uint64_t p12 = static_cast<uint64_t>(NttPrime1) * NttPrime2;
+
+	//	x = x12 + P1 * P2 * k3 < 2^87 в двух словах (high, low),
+	//	перенос идет кусками по 32 бита
+	size_t n = na + nb;
+	std::fill(out, out + n, 0);
+	uint64_t flag = 0;
+	for (size_t k = 0; k < n * NttPieces; ++k) {
+		uint64_t x1 = 0, x2 = 0, x3 = 0;
+		if (k < r1.size()) {
+			x1 = r1[k];
+			x2 = r2[k];
+			x3 = r3[k];
+		}
+		uint64_t k2 = (x2 + NttPrime2 - x1 % NttPrime2) * inv1 % NttPrime2;
+		uint64_t x12 = x1 + NttPrime1 * k2;
+		uint64_t k3 = (x3 + NttPrime3 - x12 % NttPrime3) * inv12 % NttPrime3;
+
+		uint64_t high;
+		uint64_t low = MulWide(p12, k3, high);
+		low += x12;
+		high += low < x12;
+		low += flag;
+		high += low < flag;
+		out[k / NttPieces] |= (low & NttPieceMask) << (NttPieceBits * (k % NttPieces));
+		flag = (low >> NttPieceBits) | (high << (64 - NttPieceBits));
+	}
+}
+
+template<uint32_t Mod>
+void big_integer::NttConvolution(const limb* a, size_t na, const limb* b, size_t nb, residues& out) {
+	size_t n = 1;
+	while (n < NttPieces * (na + nb))
+		n <<= 1;
+	residues fa(n, 0), fb;
+	for (size_t i = 0; i < na; ++i) {
+		for (unsigned k = 0; k < NttPieces; ++k)
+			fa[NttPieces * i + k] = static_cast<uint32_t>(((a[i] >> (NttPieceBits * k)) & NttPieceMask) % Mod);
+	}
+	Ntt<Mod>(fa, false);
+	if (a == b && na == nb) {
+		for (size_t i = 0; i < n; ++i)
+			fa[i] = static_cast<uint32_t>(static_cast<uint64_t>(fa[i]) * fa[i] % Mod);
 	}
 	else {
-		for (; countInsum < vectorSizeFor2 && flag != 0; ++countInsum) {
-			this->HelperForSummer(flag, countInsum);
+		fb.assign(n, 0);
+		for (size_t i = 0; i < nb; ++i) {
+			for (unsigned k = 0; k < NttPieces; ++k)
+				fb[NttPieces * i + k] = static_cast<uint32_t>(((b[i] >> (NttPieceBits * k)) & NttPieceMask) % Mod);
+		}
+		Ntt<Mod>(fb, false);
+		for (size_t i = 0; i < n; ++i)
+			fa[i] = static_cast<uint32_t>(static_cast<uint64_t>(fa[i]) * fb[i] % Mod);
+	}
+	Ntt<Mod>(fa, true);
+	fa.resize(NttPieces * (na + nb));
+	out.swap(fa);
+}
+
+//	прямое преобразование (прореживание по частоте) оставляет результат в
+//	обратном порядке битов, обратное (прореживание по времени) его и
+//	принимает, так что перестановка не нужна: поточечному умножению порядок
+//	безразличен. Корни длины 2h лежат в roots[h..2h); четные степени берутся
+//	из предыдущего уровня, и умножения не выстраиваются в цепочку
+template<uint32_t Mod>
+void big_integer::Ntt(residues& a, bool invert) {
+	size_t n = a.size();
+	residues roots(std::max<size_t>(n, 2));
+	roots[1] = 1;
+	for (size_t half = 2; half < n; half <<= 1) {
+		uint64_t w = PowMod<Mod>(3, (Mod - 1) / (2 * half));
+		if (invert)
+			w = PowMod<Mod>(w, Mod - 2);
+		for (size_t k = 0; k < half; k += 2) {
+			roots[half + k] = roots[half / 2 + k / 2];
+			roots[half + k + 1] = static_cast<uint32_t>(roots[half + k] * w % Mod);
 		}
 	}
-	if (flag != 0)
-		v.push_back(flag);
+
+	if (!invert) {
+		NttForward<Mod>(a.data(), n, roots.data());
+		return;
+	}
+	NttInverse<Mod>(a.data(), n, roots.data());
+	uint64_t inv = PowMod<Mod>(n, Mod - 2);
+	for (size_t i = 0; i < n; ++i)
+		a[i] = static_cast<uint32_t>(a[i] * inv % Mod);
+}
+
+//	значения многочлена p0 + p1 x + p2 x^2 (куски по k лимбов) в точках 1, -1 и -2
+void big_integer::ToomEvaluate(const limb* p, size_t n, size_t k, limbs& p1, limbs& pm1, bool& pm1Neg, limbs& pm2, bool& pm2Neg) {
+	limbs p0(p, p + std::min(k, n));
+	limbs mid(p + std::min(k, n), p + std::min(2 * k, n));
+	limbs p2(p + std::min(2 * k, n), p + n);
+	Trim(p0);
+	Trim(mid);
+	Trim(p2);
+
+	limbs sum = p0;
+	bool sumNeg = false;
+	AddSigned(sum, sumNeg, p2, false);
+	p1 = sum;
+	bool p1Neg = false;
+	AddSigned(p1, p1Neg, mid, false);
+	pm1 = sum;
+	pm1Neg = false;
+	AddSigned(pm1, pm1Neg, mid, true);
+
+	pm2 = pm1;
+	pm2Neg = pm1Neg;
+	AddSigned(pm2, pm2Neg, p2, false);
+	limbs twice = pm2;
+	AddSigned(pm2, pm2Neg, twice, pm2Neg);
+	AddSigned(pm2, pm2Neg, p0, true);
+}
+
+void big_integer::MulSigned(const limbs& a, bool aNeg, const limbs& b, bool bNeg, limbs& out, bool& outNeg) {
+	out.assign(a.size() + b.size(), 0);
+	if (!a.empty() && !b.empty())
+		MulLimbs(a.data(), a.size(), b.data(), b.size(), out.data());
+	Trim(out);
+	outNeg = !out.empty() && aNeg != bNeg;
+}
+
+//	a += (bNeg ? -b : b) над знаковыми величинами без ведущих нулевых лимбов
+void big_integer::AddSigned(limbs& a, bool& aNeg, const limbs& b, bool bNeg) {
+	if (aNeg == bNeg || a.empty()) {
+		if (a.empty())
+			aNeg = bNeg;
+		a.resize(std::max(a.size(), b.size()) + 1, 0);
+		AddTo(a.data(), a.size(), b.data(), b.size());
+	}
+	else if (CompareLimbs(a.data(), a.size(), b.data(), b.size()) >= 0) {
+		SubFrom(a.data(), a.size(), b.data(), b.size());
+	}
+	else {
+		limbs temp = b;
+		SubFrom(temp.data(), temp.size(), a.data(), a.size());
+		a.swap(temp);
+		aNeg = bNeg;
+	}
+	Trim(a);
+	if (a.empty())
+		aNeg = false;
 }
 
-void big_integer::HelperForSummer(int& flag, size_t countInsum, int temp) {
-	v[countInsum] += (temp + flag);
-	if (v[countInsum] > 9) {
-		v[countInsum] %= 10;
-		flag = 1;
-	}
-	else {
-		flag = 0;
+//	точное деление на 3 от младших лимбов через обратный к 3 по модулю 2^64
+void big_integer::DivExact3(limbs& a) {
+	constexpr limb Inverse3 = 0xAAAA'AAAA'AAAA'AAABull;
+	limb flag = 0;
+	for (size_t i = 0; i < a.size(); ++i) {
+		limb temp = a[i];
+		limb low = temp - flag;
+		flag = (low > temp) ? 1 : 0;
+		limb q = low * Inverse3;
+		a[i] = q;
+		limb high;
+		MulWide(q, 3, high);
+		flag += high;
+	}
+	Trim(a);
+}
+
+void big_integer::Halve(limbs& a) {
+	ShiftRight(a.data(), a.size(), 1);
+	Trim(a);
+}
+
+//	режет больший операнд на куски длины nb и складывает частичные произведения
+void big_integer::MulUnbalanced(const limb* a, size_t na, const limb* b, size_t nb, limb* out) {
+	std::fill(out, out + na + nb, 0);
+	limbs temp(2 * nb);
+	for (size_t i = 0; i < na; i += nb) {
+		size_t len = std::min(nb, na - i);
+		MulLimbs(a + i, len, b, nb, temp.data());
+		AddTo(out + i, na + nb - i, temp.data(), len + nb);
+	}
+}
+
+void big_integer::Trim(limbs& a) {
+	while (!a.empty() && a.back() == 0)
+		a.pop_back();
+}
+
+int big_integer::CompareLimbs(const limb* a, size_t na, const limb* b, size_t nb) {
+	while (na > 0 && a[na - 1] == 0)
+		--na;
+	while (nb > 0 && b[nb - 1] == 0)
+		--nb;
+	if (na != nb)
+		return (na < nb) ? -1 : 1;
+	for (size_t i = na; i != 0; --i) {
+		if (a[i - 1] != b[i - 1])
+			return (a[i - 1] < b[i - 1]) ? -1 : 1;
+	}
+	return 0;
+}
+
+//	выбирает деление по размеру делителя и частного
+void big_integer::DivModLimbs(limbs u, limbs w, limbs& q, limbs& r) {
+	Trim(u);
+	Trim(w);
+	if (w.size() >= BurnikelThreshold && u.size() >= w.size() + BurnikelThreshold)
+		DivideBurnikel(u, w, q, r);
+	else
+		DivideLimbs(u, w, q, r);
+}
+
+//	рекурсивное деление Буркеля - Циглера: делитель нормализуется сдвигом
+//	и дополняется нулевыми лимбами до длины j * 2^k, делимое режется на блоки
+//	этой длины, и каждая пара блоков делится через Div2n1n за время порядка
+//	умножения
+void big_integer::DivideBurnikel(limbs u, limbs w, limbs& q, limbs& r) {
+	size_t n = w.size();
+	size_t m = 1;
+	while (m * BurnikelThreshold <= n)
+		m <<= 1;
+	size_t block = (n + m - 1) / m * m;
+	size_t shift = block - n;
+
+	unsigned s = std::countl_zero(w.back());
+	u.push_back(ShiftLeft(u.data(), u.size(), s));
+	ShiftLeft(w.data(), w.size(), s);
+	u.insert(u.begin(), shift, 0);
+	w.insert(w.begin(), shift, 0);
+	Trim(u);
+
+	//	старший блок делимого короче block лимбов, значит он меньше w
+	size_t t = std::max<size_t>(2, u.size() / block + 1);
+	limbs z = Slice(u, (t - 2) * block, 2 * block);
+	q.assign((t - 1) * block, 0);
+	for (size_t i = t - 1; i-- != 0;) {
+		limbs qi;
+		Div2n1n(z, w, block, qi, r);
+		std::copy(qi.begin(), qi.end(), q.begin() + i * block);
+		if (i != 0) {
+			z = Slice(u, (i - 1) * block, block);
+			z.resize(block, 0);
+			z.insert(z.end(), r.begin(), r.end());
+			Trim(z);
+		}
+	}
+	Trim(q);
+
+	r.erase(r.begin(), r.begin() + std::min(shift, r.size()));
+	ShiftRight(r.data(), r.size(), s);
+	Trim(r);
+}
+
+//	a < b * B^n, b нормализован и занимает n лимбов
+void big_integer::Div2n1n(const limbs& a, const limbs& b, size_t n, limbs& q, limbs& r) {
+	if (n % 2 != 0 || n < BurnikelThreshold) {
+		DivideLimbs(a, b, q, r);
+		return;
+	}
+	size_t h = n / 2;
+	limbs q1, r1;
+	Div3n2n(Slice(a, h, 3 * h), b, h, q1, r1);
+
+	limbs low = Slice(a, 0, h);
+	low.resize(h, 0);
+	low.insert(low.end(), r1.begin(), r1.end());
+	Trim(low);
+	Div3n2n(low, b, h, q, r);
+
+	q.resize(h, 0);
+	q.insert(q.end(), q1.begin(), q1.end());
+	Trim(q);
+}
+
+//	a < b * B^h, b = b1 * B^h + b2 нормализован и занимает 2h лимбов
+void big_integer::Div3n2n(const limbs& a, const limbs& b, size_t h, limbs& q, limbs& r) {
+	limbs b1 = Slice(b, h, h);
+	limbs b2 = Slice(b, 0, h);
+	limbs a12 = Slice(a, h, 2 * h);
+
+	if (CompareLimbs(Slice(a, 2 * h, h).data(), Slice(a, 2 * h, h).size(), b1.data(), b1.size()) < 0) {
+		Div2n1n(a12, b1, h, q, r);
+	}
+	else {
+		//	q = B^h - 1, r = a12 - b1 * B^h + b1
+		q.assign(h, UINT64_MAX);
+		r = a12;
+		bool rNeg = false;
+		limbs temp(h, 0);
+		temp.insert(temp.end(), b1.begin(), b1.end());
+		AddSigned(r, rNeg, temp, true);
+		AddSigned(r, rNeg, b1, false);
+	}
+
+	limbs d(q.size() + b2.size(), 0);
+	if (!q.empty() && !b2.empty())
+		MulLimbs(q.data(), q.size(), b2.data(), b2.size(), d.data());
+	Trim(d);
+
+	limbs low = Slice(a, 0, h);
+	low.resize(h, 0);
+	low.insert(low.end(), r.begin(), r.end());
+	Trim(low);
+	r.swap(low);
+	bool rNeg = false;
+	AddSigned(r, rNeg, d, true);
+	limbs one(1, 1);
+	while (rNeg) {
+		AddSigned(r, rNeg, b, false);
+		SubFrom(q.data(), q.size(), one.data(), 1);
+	}
+	Trim(q);
+}
+
+//	копия лимбов [from, from + len) без ведущих нулей
+big_integer::limbs big_integer::Slice(const limbs& a, size_t from, size_t len) {
+	if (from >= a.size())
+		return limbs();
+	limbs ans(a.begin() + from, a.begin() + std::min(a.size(), from + len));
+	Trim(ans);
+	return ans;
+}
+
+//	нормализованное деление Кнута (алгоритм D): делитель и делимое сдвигаются
+//	влево, пока старший бит делителя не станет единицей, цифра частного
+//	оценивается делением двух старших лимбов остатка и уточняется не более
+//	чем двумя поправками
+void big_integer::DivideLimbs(limbs u, limbs w, limbs& q, limbs& r) {
+	Trim(u);
+	Trim(w);
+	q.clear();
+	r.clear();
+	if (CompareLimbs(u.data(), u.size(), w.data(), w.size()) < 0) {
+		r.swap(u);
+		return;
+	}
+	if (w.size() == 1) {
+		limb rest = DivSmallLimbs(u, w[0]);
+		q.swap(u);
+		if (rest != 0)
+			r.push_back(rest);
+		return;
+	}
+
+	size_t n = w.size();
+	size_t m = u.size() - n;
+	unsigned s = std::countl_zero(w.back());
+	u.push_back(ShiftLeft(u.data(), u.size(), s));
+	ShiftLeft(w.data(), n, s);
+
+	limb top = w[n - 1];
+	limb second = w[n - 2];
+	q.assign(m + 1, 0);
+	for (size_t j = m + 1; j-- != 0;) {
+		limb qhat, rhat;
+		bool exact = true;
+		if (u[j + n] >= top) {
+			qhat = UINT64_MAX;
+			rhat = u[j + n - 1] + top;
+			exact = rhat >= top;
+		}
+		else {
+			qhat = DivWide(u[j + n], u[j + n - 1], top, rhat);
+		}
+		while (exact) {
+			limb high;
+			limb low = MulWide(qhat, second, high);
+			if (high < rhat || (high == rhat && low <= u[j + n - 2]))
+				break;
+			--qhat;
+			rhat += top;
+			exact = rhat >= top;
+		}
+
+		limb borrow = SubMul1(u.data() + j, w.data(), n, qhat);
+		limb temp = u[j + n];
+		u[j + n] = temp - borrow;
+		if (temp < borrow) {
+			--qhat;
+			AddTo(u.data() + j, n + 1, w.data(), n);
+		}
+		q[j] = qhat;
 	}
+	Trim(q);
+
+	u.resize(n);
+	ShiftRight(u.data(), n, s);
+	r.swap(u);
+	Trim(r);
 }
 
-bool big_integer::HelperForOperatorLowandBig(const big_integer& a, const big_integer& b) const {
-	size_t count = a.v.size() - 1;
-	for (; count > 0 && a.v[count] == b.v[count]; --count) {}
-	return (a.v[count] > b.v[count]) ? true : false;
+//	делит на один лимб от старших к младшим, возвращает остаток
+big_integer::limb big_integer::DivSmallLimbs(limbs& a, limb d) {
+	limb rest = 0;
+	for (size_t i = a.size(); i != 0; --i)
+		a[i - 1] = DivWide(rest, a[i - 1], d, rest);
+	Trim(a);
+	return rest;
 }
 
-void big_integer::Multiply(const big_integer& a, const big_integer& b) {
-	std::vector<int8_t> temp;
-	int flag = 0;
-	int flag2 = 0;
-	int temp2 = 0;
-	temp.resize(b.v.size() + a.v.size(), 0);
-	for (size_t i = 0; i < a.v.size(); ++i) {
-		for (size_t k = 0; k < b.v.size(); ++k) {
-			temp2 = a.v[i] * b.v[k] + flag;
-			if (temp2 > 9) {
-				flag = temp2 / 10;
-				temp2 %= 10;
-			}
-			else {
-				flag = 0;
-			}
-			temp[k + i] = temp[k + i] + temp2 + flag2;
-			if (temp[k + i] > 9) {
-				flag2 = temp[k + i] / 10;
-				temp[k + i] %= 10;
-			}
-			else {
-				flag2 = 0;
-			}
-		}
-		if (flag != 0 || flag2 != 0)
-			temp[b.v.size() + i] = flag + flag2;
-		flag = 0;
-		flag2 = 0;
-	}
-	v.resize(temp.size());
-	v.swap(temp);
-	if (v.back() == 0)
-		v.pop_back();
+//	сдвиг на s < 64 бит к старшим лимбам; возвращает выдвинутые биты
+big_integer::limb big_integer::ShiftLeft(limb* a, size_t n, unsigned s) {
+	if (s == 0 || n == 0)
+		return 0;
+	limb flag = a[n - 1] >> (LimbBits - s);
+	for (size_t i = n - 1; i != 0; --i)
+		a[i] = (a[i] << s) | (a[i - 1] >> (LimbBits - s));
+	a[0] <<= s;
+	return flag;
+}
+
+//	сдвиг на s < 64 бит к младшим лимбам; младшие биты отбрасываются
+void big_integer::ShiftRight(limb* a, size_t n, unsigned s) {
+	if (s == 0 || n == 0)
+		return;
+	for (size_t i = 0; i + 1 < n; ++i)
+		a[i] = (a[i] >> s) | (a[i + 1] << (LimbBits - s));
+	a[n - 1] >>= s;
+}
+
+//	a[0, na) += b[0, nb), nb <= na; возвращает перенос из старшего лимба
+big_integer::limb big_integer::AddTo(limb* a, size_t na, const limb* b, size_t nb) {
+	unsigned char flag = 0;
+	size_t i = 0;
+	for (; i < nb; ++i)
+		flag = AddCarry(flag, a[i], b[i], a[i]);
+	for (; i < na && flag != 0; ++i)
+		flag = AddCarry(flag, a[i], 0, a[i]);
+	return flag;
+}
+
+//	a[0, na) -= b[0, nb), nb <= na; возвращает заём из старшего лимба
+big_integer::limb big_integer::SubFrom(limb* a, size_t na, const limb* b, size_t nb) {
+	unsigned char flag = 0;
+	size_t i = 0;
+	for (; i < nb; ++i)
+		flag = SubBorrow(flag, a[i], b[i], a[i]);
+	for (; i < na && flag != 0; ++i)
+		flag = SubBorrow(flag, a[i], 0, a[i]);
+	return flag;
+}
+
+//	a[0, n) += b[0, n) * m одной цепочкой переносов; возвращает перенос
+big_integer::limb big_integer::AddMul1(limb* a, const limb* b, size_t n, limb m) {
+	limb flag = 0;
+	for (size_t i = 0; i < n; ++i) {
+		limb high;
+		limb low = MulWide(b[i], m, high);
+		low += flag;
+		high += low < flag;
+		limb temp = a[i] + low;
+		high += temp < low;
+		a[i] = temp;
+		flag = high;
+	}
+	return flag;
+}
+
+//	a[0, n) -= b[0, n) * m; возвращает заем из старшего лимба
+big_integer::limb big_integer::SubMul1(limb* a, const limb* b, size_t n, limb m) {
+	limb flag = 0;
+	for (size_t i = 0; i < n; ++i) {
+		limb high;
+		limb low = MulWide(b[i], m, high);
+		low += flag;
+		high += low < flag;
+		limb temp = a[i];
+		a[i] = temp - low;
+		high += temp < low;
+		flag = high;
+	}
+	return flag;
+}
+
+//	число бит модуля; 0 для нуля
+size_t big_integer::BitSize() const {
+	return LimbBits * (v.size() - 1) + std::bit_width(v.back());
+}
+
+//	число десятичных цифр модуля; 1 для нуля. Оценка по числу бит ошибается
+//	не больше чем на одну цифру и уточняется сравнением со степенью 10
+size_t big_integer::DecimalSize() const {
+	if (v.size() == 1) {
+		size_t count = 1;
+		while (count < 20 && v[0] >= SmallPowers10[count])
+			++count;
+		return count;
+	}
+	size_t count = static_cast<size_t>(static_cast<double>(this->BitSize() - 1) * 0.30102999566398120);
+	if (count > 0)
+		--count;
+	while (big_integer_view::compareMagnitude(*this, pow10(count + 1)) >= 0)
+		++count;
+	return count + 1;
 }
 
+//	модуль INT64_MIN тоже помещается в один лимб
 template <typename T>
 void big_integer::evaluate(T a) {
-	if (a == 0)
-		sign = true;
-	if (a < 0) {
-		sign = false;
-		while (a < -9)
-		{
-			v.push_back((a % 10) * -1);
-			a /= 10;
-		};
-		v.push_back(a * -1);
-	}
-	else {
-		while (a > 9)
-		{
-			v.push_back(a % 10);
-			a /= 10;
-		};
-		v.push_back(a);
+	uint64_t d = static_cast<uint64_t>(a);
+	if constexpr (std::is_signed_v<T>) {
+		if (a < 0) {
+			sign = false;
+			d = 0 - d;
+		}
 	}
+	v.push_back(d);
+}
+
+//	емкость под n лимбов, чтобы следующие операции не перевыделяли буфер
+void big_integer::reserve(size_t n) {
+	v.reserve(n);
+}
+
+std::pmr::memory_resource* big_integer::get_resource() const {
+	return v.resource();
+}
+
+big_integer_view big_integer::view() const {
+	return big_integer_view(v.data(), v.size(), sign);
 }
 
 big_integer big_integer::Abs() const {
@@ -754,57 +2758,121 @@ big_integer big_integer::Abs() const {
 	return temp;
 }
 
-big_integer& big_integer::reverse() {
-	for (size_t i = 0, j = v.size() - 1; i < v.size() / 2; ++i, --j)
-		std::swap(v[i], v[j]);
+//	*this * 10^k: остаток k по модулю 16 - одно умножение на слово, старшие
+//	биты k - степени 10^(2^i) из кэша потока. Ноль остается нулем
+big_integer& big_integer::shift_decimal(size_t k) {
+	if (k == 0 || this->view().isZero())
+		return *this;
+	size_t low = k % DecimalChunkDigits;
+	if (low != 0)
+		this->MulMagnitude(SmallPowers10[low]);
+	k /= DecimalChunkDigits;
+	big_integer above;
+	for (size_t i = std::countr_zero(DecimalChunkDigits); k != 0; ++i, k >>= 1) {
+		//	степени выше кэша потока живут только на время вызова
+		if (i >= DecimalCachedLevels) {
+			if (i == DecimalCachedLevels)
+				above = DecimalPower(i - 1);
+			above.square();
+		}
+		if (k & 1)
+			*this *= (i < DecimalCachedLevels) ? DecimalPower(i) : above;
+	}
 	return *this;
 }
 
+//	*this / 10^k с отбрасыванием остатка, как operator/
+big_integer& big_integer::unshift_decimal(size_t k) {
+	if (k < std::size(SmallPowers10))
+		this->divmod_small(SmallPowers10[k]);
+	else if (this->BitSize() <= 3 * k)
+		this->SetZero();
+	else
+		*this /= pow10(k);
+	return *this;
+}
 
-bool big_integer::getSign() const {
-	return sign;
+big_integer big_integer::pow10(size_t k) {
+	big_integer temp = 1;
+	temp.shift_decimal(k);
+	return temp;
 }
 
-const big_integer* big_integer::getbiggerSize(const big_integer& other) const {
-	return (v.size() >= other.v.size()) ? this : &other;
+//	переставляет десятичные цифры модуля; ведущие нули результата пропадают
+big_integer& big_integer::reverse() {
+	bool tempSign = sign;
+	std::string temp = this->Abs().to_string();
+	std::reverse(temp.begin(), temp.end());
+	this->CheckSignAndWrite(temp.data(), temp.data() + temp.size());
+	if (!tempSign && v.back() != 0)
+		sign = false;
+	return *this;
 }
 
-const big_integer* big_integer::getSmallestSize(const big_integer& other) const {
-	return (v.size() < other.v.size()) ? this : &other;
+
+bool big_integer::getSign() const {
+	return sign;
 }
 
-void big_integer::swap(big_integer other) {
+void big_integer::swap(big_integer& other) noexcept {
 	v.swap(other.v);
-	sign = other.sign;
+	std::swap(sign, other.sign);
 }
 
-big_integer big_integer::join(const big_integer& other) const {
-	big_integer temp = other;
-	temp.sign = sign;
-	temp.v.insert(temp.v.end(), v.begin(), v.end());
+//	|*this| * 10^scale + fraction со знаком *this: целая часть и дробные
+//	цифры rational в одном целом
+big_integer big_integer::join(const big_integer& fraction, size_t scale) const {
+	big_integer temp = this->Abs();
+	temp.shift_decimal(scale);
+	temp += fraction;
+	if (!sign)
+		temp.NegateUnlessZero();
 	return temp;
 }
 
+//	обратно к join: младшие precious десятичных цифр уходят в дробь
 rational big_integer::disjoin(size_t precious) {
-	size_t count = v.size() - precious;
-	big_integer nom = 0;
-	big_integer denom = 0;
-	nom.v.resize(count);
-	memcpy(nom.v.data(), v.data() + precious, count);
-	v.erase(v.begin() + precious, v.end());
-	denom = *this;
-	nom.sign = sign;
-	return rational (nom, denom);
+	bool tempSign = sign;
+	sign = true;
+	rational ans;
+	if (precious < std::size(SmallPowers10)) {
+		ans.nom = *this;
+		ans.denom = ans.nom.divmod_small(SmallPowers10[precious]);
+	}
+	else {
+		this->divmod(pow10(precious), ans.nom, ans.denom);
+	}
+	ans.scale = precious;
+	ans.nom.sign = tempSign || (ans.nom == 0 && ans.denom == 0);
+	return ans;
 }
 
+namespace {
+	//	первые n цифр f, округленные по цифре f[n]; перенос из старшей цифры
+	//	дописывает единицу слева. При n >= f.size() f возвращается целиком
+	std::string RoundDigits(const std::string& f, size_t n) {
+		if (n >= f.size())
+			return f;
+		std::string ans = f.substr(0, n);
+		if (f[n] < '5')
+			return ans;
+		size_t i = n;
+		for (; i != 0 && ans[i - 1] == '9'; --i)
+			ans[i - 1] = '0';
+		if (i == 0)
+			ans.insert(ans.begin(), '1');
+		else
+			++ans[i - 1];
+		return ans;
+	}
+}
+
+//	старшие n цифр модуля, округленные по следующей цифре
 big_integer big_integer::round(size_t n) const {
-	big_integer temp;
-	temp.v.resize(n);
-	size_t index = v.size() - n;
-	memcpy(temp.v.data(), v.data() + index, n);
-	if (v[index - 1] >= 5)
-		++temp;
-	return temp;
+	std::string temp = RoundDigits(this->Abs().to_string(), n);
+	if (temp.empty())
+		return big_integer();
+	return big_integer(temp);
 }
 
 void big_integer::HelperForCtorFromDouble(double d) {
@@ -834,6 +2902,334 @@ void big_integer::HelperForCtorFromDouble(double d) {
 	sign = (d < 0) ? false : true;
 }
 
+//                                      РАБОЧАЯ ПАМЯТЬ
+namespace {
+	thread_local big_integer::workspace* currentWorkspace = nullptr;
+	//	после разрушения кэша потока блоки идут напрямую в кучу
+	thread_local bool threadCacheDestroyed = false;
+}
+
+big_integer::workspace::workspace(): previous(currentWorkspace), pinned(true) {
+	currentWorkspace = this;
+}
+
+big_integer::workspace::workspace(ThreadDefault): pinned(false) {}
+
+big_integer::workspace::~workspace() {
+	if (pinned)
+		currentWorkspace = previous;
+	else
+		threadCacheDestroyed = true;
+	this->release();
+}
+
+void big_integer::workspace::release() {
+	for (size_t k = 0; k < ClassCount; ++k) {
+		while (freeLists[k] != nullptr) {
+			FreeBlock* next = freeLists[k]->next;
+			::operator delete(freeLists[k]);
+			freeLists[k] = next;
+		}
+	}
+	cachedBytes = 0;
+}
+
+size_t big_integer::workspace::cached() const {
+	return cachedBytes;
+}
+
+//	наименьшее k, при котором MinBlock * 2^k >= n
+size_t big_integer::workspace::SizeClass(size_t n) {
+	return (n <= MinBlock) ? 0 : std::bit_width(n - 1) - std::bit_width(MinBlock - 1);
+}
+
+void* big_integer::workspace::Allocate(size_t n) {
+	if (n > MaxBlock)
+		return ::operator new(n);
+	size_t k = SizeClass(n);
+	if (freeLists[k] == nullptr)
+		return ::operator new(MinBlock << k);
+	FreeBlock* block = freeLists[k];
+	freeLists[k] = block->next;
+	cachedBytes -= MinBlock << k;
+	return block;
+}
+
+void big_integer::workspace::Free(void* p, size_t n) {
+	size_t k = SizeClass(n);
+	if (n > MaxBlock || cachedBytes + (MinBlock << k) > MaxCached) {
+		::operator delete(p);
+		return;
+	}
+	FreeBlock* block = static_cast<FreeBlock*>(p);
+	block->next = freeLists[k];
+	freeLists[k] = block;
+	cachedBytes += MinBlock << k;
+}
+
+big_integer::workspace* big_integer::CurrentWorkspace() {
+	if (currentWorkspace != nullptr)
+		return currentWorkspace;
+	if (threadCacheDestroyed)
+		return nullptr;
+	thread_local workspace threadDefault{ workspace::ThreadDefault() };
+	return &threadDefault;
+}
+
+void* big_integer::ScratchAllocate(size_t n) {
+	workspace* ws = CurrentWorkspace();
+	if (ws != nullptr)
+		return ws->Allocate(n);
+	//	размер класса: блок может вернуться в кэш другого потока
+	return ::operator new((n > workspace::MaxBlock) ? n : workspace::MinBlock << workspace::SizeClass(n));
+}
+
+//	блок мог быть взят из другого кэша: все они выделены через operator new
+void big_integer::ScratchFree(void* p, size_t n) {
+	workspace* ws = CurrentWorkspace();
+	if (ws != nullptr)
+		ws->Free(p, n);
+	else
+		::operator delete(p);
+}
+
+//                                      ФИКСИРОВАННЫЙ МОДУЛЬ
+big_integer::modulus_context::modulus_context(const big_integer& b): m(b.Abs()) {
+	if (b == 0)
+		throw std::invalid_argument("division by zero");
+
+	m.TrimDigits();
+	mod = m.ToLimbs();
+	Trim(mod);
+	k = mod.size();
+
+	mu = Reciprocal(mod);
+
+	montgomery = mod[0] % 2 != 0 && (k > 1 || mod[0] > 1);
+	if (montgomery) {
+		//	обратный к mod[0] по модулю 2^64 итерациями Ньютона: нечетное
+		//	число обратно само себе по модулю 8, каждый шаг удваивает точность
+		limb inv = mod[0];
+		for (int i = 0; i < 5; ++i)
+			inv *= 2 - mod[0] * inv;
+		minv = 0 - inv;
+
+		//	B^2k mod mod: частное mu уже известно с точностью до нескольких единиц
+		limbs product(mu.size() + k + 1, 0);
+		MulLimbs(mu.data(), mu.size(), mod.data(), k, product.data());
+		Trim(product);
+		r2.assign(2 * k + 1, 0);
+		r2.back() = 1;
+		while (CompareLimbs(product.data(), product.size(), r2.data(), r2.size()) > 0) {
+			SubFrom(product.data(), product.size(), mod.data(), k);
+			Trim(product);
+		}
+		SubFrom(r2.data(), r2.size(), product.data(), product.size());
+		Trim(r2);
+		while (CompareLimbs(r2.data(), r2.size(), mod.data(), k) >= 0) {
+			SubFrom(r2.data(), r2.size(), mod.data(), k);
+			Trim(r2);
+		}
+	}
+}
+
+big_integer big_integer::modulus_context::reduce(const big_integer& a) const {
+	big_integer ans;
+	ans.AssignLimbs(ReduceLimbs(a.ToLimbs()), a.sign);
+	return ans;
+}
+
+big_integer big_integer::modulus_context::mul(const big_integer& a, const big_integer& b) const {
+	big_integer ans;
+	ans.AssignLimbs(MulMod(ReduceLimbs(a.ToLimbs()), ReduceLimbs(b.ToLimbs())), a.sign == b.sign);
+	return ans;
+}
+
+big_integer big_integer::modulus_context::pow(const big_integer& a, const big_integer& e) const {
+	if (!e.sign && (e.v.size() > 1 || e.v[0] != 0))
+		throw std::invalid_argument("negative exponent");
+
+	big_integer ans;
+	bool odd = e.v[0] % 2 != 0;
+	ans.AssignLimbs(PowLimbs(ReduceLimbs(a.ToLimbs()), e), a.sign || !odd);
+	return ans;
+}
+
+const big_integer& big_integer::modulus_context::modulus() const {
+	return m;
+}
+
+//	частное и остаток с теми же знаками, что у big_integer::divmod; для
+//	|a| < модуль^2 это два умножения вместо деления
+std::pair<big_integer, big_integer> big_integer::modulus_context::divmod(const big_integer& a) const {
+	limbs q, r;
+	DivLimbs(a.ToLimbs(), q, r);
+	std::pair<big_integer, big_integer> ans;
+	ans.first.AssignLimbs(q, a.sign);
+	ans.second.AssignLimbs(r, a.sign);
+	return ans;
+}
+
+//	floor(B^2k / d) для d из k лимбов, у длинного d - с точностью до
+//	нескольких единиц. Обратная к старшим h > k / 2 + 2 лимбам, сдвинутая на
+//	k - h лимбов, отличается от ответа в 1 + O(B^(1-h)) раз, и шаг Ньютона
+//	x + x(B^2k - dx) / B^2k возводит ошибку в квадрат. В шаге участвуют только
+//	старшие лимбы B^2k - dx: младшие h - 2 меняют результат меньше чем на 1
+big_integer::limbs big_integer::modulus_context::Reciprocal(const limbs& d) {
+	size_t k = d.size();
+	if (k < ReciprocalThreshold) {
+		limbs power(2 * k + 1, 0);
+		power.back() = 1;
+		limbs q, r;
+		DivModLimbs(power, d, q, r);
+		return q;
+	}
+
+	size_t h = k / 2 + 3;
+	size_t s = k - h;
+	limbs top = Reciprocal(limbs(d.end() - h, d.end()));
+
+	//	x = top * B^s, а B^2k - dx = (B^(k+h) - d * top) * B^s
+	limbs x(s + top.size() + 1, 0);
+	std::copy(top.begin(), top.end(), x.begin() + s);
+	limbs product(k + top.size(), 0);
+	MulLimbs(d.data(), k, top.data(), top.size(), product.data());
+	Trim(product);
+	limbs edge(k + h + 1, 0);
+	edge.back() = 1;
+	bool negative = CompareLimbs(product.data(), product.size(), edge.data(), edge.size()) > 0;
+	limbs error = negative ? product : edge;
+	if (negative)
+		SubFrom(error.data(), error.size(), edge.data(), edge.size());
+	else
+		SubFrom(error.data(), error.size(), product.data(), product.size());
+	error = Slice(error, h - 2, error.size());
+	if (!error.empty()) {
+		limbs step(top.size() + error.size(), 0);
+		MulLimbs(top.data(), top.size(), error.data(), error.size(), step.data());
+		step = Slice(step, h + 2, step.size());
+		if (negative)
+			SubFrom(x.data(), x.size(), step.data(), step.size());
+		else
+			AddTo(x.data(), x.size(), step.data(), step.size());
+	}
+	Trim(x);
+	return x;
+}
+
+//	Барретт: для a < B^2k частное оценивается как ((a / B^(k-1)) * mu) / B^(k+1)
+//	и ошибается на несколько единиц в любую сторону, их снимают поправки;
+//	большие a делятся обычным путем
+void big_integer::modulus_context::DivLimbs(limbs a, limbs& q, limbs& r) const {
+	Trim(a);
+	if (CompareLimbs(a.data(), a.size(), mod.data(), k) < 0) {
+		q.clear();
+		r = std::move(a);
+		return;
+	}
+	if (a.size() > 2 * k) {
+		DivModLimbs(a, mod, q, r);
+		return;
+	}
+
+	limbs q1(a.begin() + (k - 1), a.end());
+	limbs q2(q1.size() + mu.size(), 0);
+	MulLimbs(q1.data(), q1.size(), mu.data(), mu.size(), q2.data());
+	q = Slice(q2, k + 1, q2.size());
+
+	limbs product(q.size() + k, 0);
+	if (!q.empty())
+		MulLimbs(q.data(), q.size(), mod.data(), k, product.data());
+	Trim(product);
+	const limb one = 1;
+	while (CompareLimbs(product.data(), product.size(), a.data(), a.size()) > 0) {
+		SubFrom(product.data(), product.size(), mod.data(), k);
+		Trim(product);
+		SubFrom(q.data(), q.size(), &one, 1);
+	}
+	Trim(q);
+	SubFrom(a.data(), a.size(), product.data(), product.size());
+	Trim(a);
+	while (CompareLimbs(a.data(), a.size(), mod.data(), k) >= 0) {
+		SubFrom(a.data(), a.size(), mod.data(), k);
+		Trim(a);
+		if (q.empty())
+			q.push_back(0);
+		if (AddTo(q.data(), q.size(), &one, 1) != 0)
+			q.push_back(1);
+	}
+	r = std::move(a);
+}
+
+big_integer::limbs big_integer::modulus_context::ReduceLimbs(limbs a) const {
+	limbs q, r;
+	DivLimbs(std::move(a), q, r);
+	return r;
+}
+
+big_integer::limbs big_integer::modulus_context::MulMod(const limbs& a, const limbs& b) const {
+	if (a.empty() || b.empty())
+		return limbs();
+	limbs product(a.size() + b.size(), 0);
+	MulLimbs(a.data(), a.size(), b.data(), b.size(), product.data());
+	return ReduceLimbs(product);
+}
+
+//	REDC: t < mod * B^k, возвращает t * B^-k mod mod
+big_integer::limbs big_integer::modulus_context::Redc(limbs t) const {
+	t.resize(2 * k + 1, 0);
+	for (size_t i = 0; i < k; ++i) {
+		limb u = t[i] * minv;
+		limb carry = AddMul1(t.data() + i, mod.data(), k, u);
+		AddTo(t.data() + i + k, t.size() - i - k, &carry, 1);
+	}
+	t.erase(t.begin(), t.begin() + k);
+	Trim(t);
+	if (CompareLimbs(t.data(), t.size(), mod.data(), k) >= 0) {
+		SubFrom(t.data(), t.size(), mod.data(), k);
+		Trim(t);
+	}
+	return t;
+}
+
+big_integer::limbs big_integer::modulus_context::MontMul(const limbs& a, const limbs& b) const {
+	if (a.empty() || b.empty())
+		return limbs();
+	limbs product(a.size() + b.size(), 0);
+	MulLimbs(a.data(), a.size(), b.data(), b.size(), product.data());
+	return Redc(product);
+}
+
+//	возведение в степень окнами по 4 бита показателя, от старших:
+//	x = x^16 * a^nibble; множители a^0 .. a^15 считаются заранее
+big_integer::limbs big_integer::modulus_context::PowLimbs(const limbs& a, const big_integer& e) const {
+	limbs one(1, 1);
+	if (k == 1 && mod[0] == 1)
+		return limbs();
+
+	auto multiply = [this](const limbs& x, const limbs& y) {
+		return montgomery ? MontMul(x, y) : MulMod(x, y);
+	};
+
+	limbs table[16];
+	table[0] = montgomery ? MontMul(r2, one) : one;
+	table[1] = montgomery ? MontMul(a, r2) : a;
+	for (int i = 2; i < 16; ++i)
+		table[i] = multiply(table[i - 1], table[1]);
+
+	limbs x = table[0];
+	for (size_t i = e.v.size(); i != 0; --i) {
+		for (int shift = LimbBits - 4; shift >= 0; shift -= 4) {
+			for (int count = 0; count < 4; ++count)
+				x = multiply(x, x);
+			unsigned nibble = (e.v[i - 1] >> shift) & 0xF;
+			if (nibble != 0)
+				x = multiply(x, table[nibble]);
+		}
+	}
+	return montgomery ? Redc(x) : x;
+}
+
 void swap(int& a, int& b) {
 	int temp = a;
 	a = b;
@@ -848,7 +3244,8 @@ rational::rational() {
 	denom = big_integer(0);
 }
 
-rational::rational(const big_integer& a, const big_integer& b): nom(a), denom(b.Abs()) {}
+//	число дробных цифр берется по десятичной длине b
+rational::rational(const big_integer& a, const big_integer& b): nom(a), denom(b.Abs()), scale(b.DecimalSize()) {}
 
 rational::rational(const big_integer& a): nom(a), denom(0) {}
 
@@ -857,12 +3254,11 @@ rational::rational(int a): nom(a), denom(0) {}
 rational::rational(double d) {  // rational поддерживает 16 точных заков от double после запятой
 	nom = d; 
 	
-	if (nom.v.size() > 15) {
+	if (nom.DecimalSize() > 15) {
 		denom = 0;
 	}
 	else {
-		big_integer tempDenom = 0;
-		std::vector<int> temp;
+		std::string temp;
 		if (d < 0) {
 			nom.sign = false;
 			d *= -1;
@@ -873,86 +3269,129 @@ rational::rational(double d) {  // rational поддерживает 16 точн
 		for (int i = 0; i < 310; ++i) {
 			tempd *= 10;
 			int a = tempd;
-			temp.push_back(a);
+			temp.push_back(static_cast<char>('0' + a));
 			tempd -= a;
 		}
 
-		tempDenom = temp;
-		tempDenom.reverse();
-		
-		size_t i = tempDenom.v.size() - 1;
-		while (i != 0 && tempDenom.v.back() == 0) {
-			tempDenom.v.pop_back();
-			--i;
-		}
+		while (temp.size() > 1 && temp.back() == '0')
+			temp.pop_back();
 
-		if (tempDenom.v.size() < 16 - nom.v.size())
-			denom = tempDenom.reverse();
+		size_t size = nom.DecimalSize();
+		if (temp.size() < 16 - size)
+			this->SetFraction(temp.data(), temp.size());
 		else {
 			
-			size_t count = 16 - nom.v.size();
-			if (tempDenom.v[count] >= 5) {
-				denom = tempDenom.reverse().round(count);
-				size_t i = denom.v.size() - 1;
-				denom.reverse();
-					
-				while (i != -1 && denom.v.back() == 0) {
-					denom.v.pop_back();
-					--i;
-				}
-				denom.reverse();
+			size_t count = 16 - size;
+			std::string tempDenom;
+			if (temp[count] >= '5') {
+				tempDenom = RoundDigits(temp, count);
+				while (!tempDenom.empty() && tempDenom.back() == '0')
+					tempDenom.pop_back();
 			}
 			else {
-				size_t i = count - 1;  
-				for (; i != -1 && tempDenom.v[i] == 0; --i);
-				if (i == -1) {
-					for (; tempDenom.v[count++] == 0;);
-					for (; tempDenom.v[count++] != 0;);
-					denom = tempDenom.reverse().round(count - 1);
+				size_t i = count;
+				for (; i != 0 && temp[i - 1] == '0'; --i);
+				if (i == 0) {
+					//	первая ненулевая цифра за count и конец ее серии
+					size_t first = temp.find_first_not_of('0', count);
+					size_t end = (first == std::string::npos) ? temp.size() : temp.find('0', first);
+					tempDenom = RoundDigits(temp, (end == std::string::npos) ? temp.size() : end);
 				}
 				else {
-					denom = tempDenom.reverse().round(i + 1);
+					tempDenom = RoundDigits(temp, i);
 				}
 			}
+			this->SetFraction(tempDenom.data(), tempDenom.size());
 		}
 	}
 }
 
- 
+//	ведущие нули дроби входят в scale
 rational::rational(const std::string& str) {
-	if (size_t indexPoint = str.find('.'); indexPoint != std::string::npos) {
-		nom = static_cast<big_integer>(str.substr(0, indexPoint));
-		denom = static_cast<big_integer>(str.substr(indexPoint + 1));
+	this->CheckPointAndWrite(str.data(), str.data() + str.size());
+}
+
+rational::rational(const char* ptr) {
+	this->CheckPointAndWrite(ptr, ptr + strlen(ptr));
+}
+
+//	целая часть и дробные цифры разбираются прямо из исходной строки, без подстрок;
+//	ведущие нули дроби входят в scale
+void rational::CheckPointAndWrite(const char* first, const char* last) {
+	const char* point = std::find(first, last, '.');
+	nom.CheckSignAndWrite(first, point);
+	if (point != last) {
+		denom.CheckSignAndWrite(point + 1, last);
+		scale = last - point - 1;
 	}
 	else {
-		nom = static_cast<big_integer>(str);
 		denom = 0;
+		scale = 1;
 	}
 }
 
-rational::rational(const char* ptr): rational(std::string(ptr)) {}
+rational::rational(const rational& other): nom(other.nom), denom(other.denom), scale(other.scale) {}
+
+rational::rational(std::pmr::memory_resource* r): nom(r), denom(r) {}
+
+rational::rational(const rational& other, std::pmr::memory_resource* r): nom(other.nom, r), denom(other.denom, r), scale(other.scale) {}
 
-rational::rational(const rational& other): nom(other.nom), denom(other.denom) {}
+rational::rational(rational&& other) noexcept: nom(std::move(other.nom)), denom(std::move(other.denom)), scale(other.scale) {
+	other.scale = 1;
+}
 
 rational& rational::operator=(const rational& other) {
-	swap(other);
+	nom = other.nom;
+	denom = other.denom;
+	scale = other.scale;
+	return *this;
+}
+
+rational& rational::operator=(rational&& other) {
+	nom = std::move(other.nom);
+	denom = std::move(other.denom);
+	scale = other.scale;
+	if (this != &other)
+		other.scale = 1;
 	return *this;
 }
 
 //												ОПЕРАТОРЫ RATIONAL
 
 std::ostream& operator<<(std::ostream& out, const rational& rat) {
-		out << rat.nom;
-		if (rat.denom != 0) {
-			out << '.' << rat.denom;
-		}
-		return out;
+	const big_integer* fraction = rat.denom.view().isZero() ? nullptr : &rat.denom;
+	big_integer::WriteNumber(out, !rat.nom.sign, rat.nom, fraction, rat.scale);
+	return out;
 }
 
+//	целая часть, затем после точки все дробные цифры, включая нули;
+//	минус сохраняется и при нулевой целой части
 std::istream& operator>>(std::istream& in, rational& rat) {
-	std::string temp;
-	in >> temp;
-	rat = static_cast<rational>(temp);
+	std::istream::sentry guard(in);
+	if (!guard)
+		return in;
+
+	std::ios_base::iostate state = std::ios_base::goodbit;
+	std::streambuf* buffer = in.rdbuf();
+	bool negative = ReadSign(buffer, state);
+	if (ReadRadixNumber(buffer, 10, rat.nom, state) == 0) {
+		rat.denom = 0;
+		rat.scale = 1;
+		in.setstate(state | std::ios_base::failbit);
+		return in;
+	}
+
+	size_t count = 0;
+	if (!(state & std::ios_base::eofbit) && buffer->sgetc() == '.') {
+		buffer->sbumpc();
+		count = ReadRadixNumber(buffer, 10, rat.denom, state);
+	}
+	if (count == 0)
+		rat.denom = 0;
+	rat.scale = std::max<size_t>(count, 1);
+
+	rat.nom.sign = !negative || (rat.nom.view().isZero() && rat.denom.view().isZero());
+	in.setstate(state);
 	return in;
 }
 
@@ -964,18 +3403,11 @@ rational& rational::operator+=(const rational& other) {
 		else if (other == 0)
 			return *this;
 
-		if (nom.sign != other.nom.sign && this->Abs() == other.Abs()) {
+		if (nom.sign != other.nom.sign && this->EqualMagnitude(other)) {
 			*this = 0;
 			return *this;
 		}
-		size_t count = denom.getbiggerSize(other.denom)->v.size();
-		if (nom.sign == other.nom.sign)
-		{
-			evaluate2(count, other, true);
-		}
-		else {
-			evaluate(count, other);
-		}
+		this->evaluate(std::max(scale, other.scale), other, true);
 	return *this;
 }
 
@@ -985,19 +3417,26 @@ rational operator+(const rational& a, const rational& b) {
 	return temp;
 }
 
+rational operator+(rational&& a, const rational& b) {
+	a += b;
+	return std::move(a);
+}
+
+rational operator+(const rational& a, rational&& b) {
+	b += a;
+	return std::move(b);
+}
+
+rational operator+(rational&& a, rational&& b) {
+	return std::move(a) + b;
+}
+
 rational& rational::operator-=(const rational& other) {
-		if (nom.sign == other.nom.sign && this->Abs() == other.Abs()) {
+		if (nom.sign == other.nom.sign && this->EqualMagnitude(other)) {
 			*this = 0;
 			return *this;
 		}
-		size_t count = denom.getbiggerSize(other.denom)->v.size();
-
-		if (nom.sign == other.nom.sign) {
-			this->evaluate(count, other);
-		}
-		else {
-			this->evaluate2(count, other, false);
-		}
+		this->evaluate(std::max(scale, other.scale), other, false);
 	return *this;
 }
 
@@ -1007,10 +3446,15 @@ rational operator-(const rational& a, const rational& b) {
 	return temp;
 }
 
+rational operator-(rational&& a, const rational& b) {
+	a -= b;
+	return std::move(a);
+}
+
 rational& rational::operator*=(const rational& other) {
-	size_t precious = denom.v.size() + other.denom.v.size();
-	big_integer a = nom.join(denom);
-	big_integer b = other.nom.join(other.denom);
+	size_t precious = scale + other.scale;
+	big_integer a = nom.join(denom, scale);
+	big_integer b = other.nom.join(other.denom, other.scale);
 	big_integer c = a * b;
 	*this = c.disjoin(precious);
 	return *this;
@@ -1022,6 +3466,20 @@ rational operator*(const rational& a, const rational& b) {
 	return temp;
 }
 
+rational operator*(rational&& a, const rational& b) {
+	a *= b;
+	return std::move(a);
+}
+
+rational operator*(const rational& a, rational&& b) {
+	b *= a;
+	return std::move(b);
+}
+
+rational operator*(rational&& a, rational&& b) {
+	return std::move(a) * b;
+}
+
 rational& rational::operator/=(const rational& other) {
 	try {
 		if (other == 0) {
@@ -1033,50 +3491,34 @@ rational& rational::operator/=(const rational& other) {
 		return *this;
 	}
 		
-	if (this->Abs() == other.Abs()) {
+	if (this->EqualMagnitude(other)) {
 		*this = ((this->nom).sign == other.nom.sign) ? 1 : -1;
 		return *this;
 	}
 
 	bool tempSign = nom.sign;
-	size_t precious = denom.getbiggerSize(other.denom)->v.size();
-	size_t smallerSize = denom.getSmallestSize(other.denom)->v.size();
-	big_integer a = nom.join(denom);
-	big_integer b = other.nom.join(other.denom);
-	a.sign = true;
-	b.sign = true;
+	size_t precious = std::max(scale, other.scale);
+	size_t smallerSize = std::min(scale, other.scale);
+	big_integer a = nom.join(denom, scale).Abs();
+	big_integer b = other.nom.join(other.denom, other.scale).Abs();
 	std::vector<int> ans;
 
-	while (a.v.back() == 0)
-		a.v.pop_back();
-	while (b.v.back() == 0)
-		b.v.pop_back();
-
-	if (denom.v.size() != other.denom.v.size()) {
-		if (a.v.size() < b.v.size()) {
-			for (int i = 0; i < precious - smallerSize; ++i)
-				a *= 10;
+	if (scale != other.scale) {
+		if (a.DecimalSize() < b.DecimalSize()) {
+			a.shift_decimal(precious - smallerSize);
 		}
 		else {
-			for (int i = 0; i < precious - smallerSize; ++i)
-				b *= 10;
+			b.shift_decimal(precious - smallerSize);
 		}
 	}
-	nom = a / b;
-	if (a % b != 0) {
-		a %= b;
-		this->evaluateForDivide(a, b, ans);
-	}
-	else if (a % b == 0 && a < b) {
-		this->evaluateForDivide(a, b, ans);
-		
-	}
+	big_integer rest;
+	a.divmod(b, nom, rest);
+	if (rest != 0)
+		this->evaluateForDivide(rest, b, ans);
 	denom = ans;
+	scale = std::max<size_t>(ans.size(), 1);
 
-	if (tempSign != other.nom.sign)
-		nom.sign = false;
-	else
-		nom.sign = true;
+	nom.sign = (tempSign == other.nom.sign) || (nom == 0 && denom == 0);
 	return *this;
 }
 
@@ -1086,6 +3528,11 @@ rational operator/(const rational& a , const rational& b) {
 	return temp;
 }
 
+rational operator/(rational&& a, const rational& b) {
+	a /= b;
+	return std::move(a);
+}
+
 
 std::partial_ordering rational::operator<=>(const rational& other) const {
 	if (*this == other)
@@ -1097,33 +3544,11 @@ std::partial_ordering rational::operator<=>(const rational& other) const {
 	}
 	else if (nom == other.nom)
 	{
-		if (denom.v.size() != other.denom.v.size())
-		{
-			size_t count = denom.getbiggerSize(other.denom)->v.size();
-			const big_integer* ptr = denom.getSmallestSize(other.denom);
-			big_integer temp = *ptr;
-			while (temp.v.size() < count)
-				temp *= 10;
-			if (ptr == &denom)
-			{
-				if (nom.sign == true)
-					return (temp < other.denom) ? std::partial_ordering::less : std::partial_ordering::greater;
-				else
-					return (temp < other.denom) ? std::partial_ordering::greater : std::partial_ordering::less;
-			}
-			else {
-				if (nom.sign == true)
-					return (denom < temp) ? std::partial_ordering::less : std::partial_ordering::greater;
-				else
-					return (denom < temp) ? std::partial_ordering::greater : std::partial_ordering::less;
-			}
-		}
-		else {
-			if (nom.sign == true)
-				return (denom < other.denom) ? std::partial_ordering::less : std::partial_ordering::greater;
-			else
-				return (denom < other.denom) ? std::partial_ordering::greater : std::partial_ordering::less;
-		}
+		int temp = CompareFractions(denom, scale, other.denom, other.scale);
+		if (nom.sign == true)
+			return (temp < 0) ? std::partial_ordering::less : std::partial_ordering::greater;
+		else
+			return (temp < 0) ? std::partial_ordering::greater : std::partial_ordering::less;
 	}
 	return std::partial_ordering::unordered;
 }
@@ -1135,18 +3560,118 @@ bool rational::operator==(const rational& other) const {
 
 	if (nom != other.nom)
 		return false;
-	else if (denom.v.size() != other.denom.v.size()) {
-		size_t count = denom.getbiggerSize(other.denom)->v.size();
-		const big_integer* ptr = denom.getSmallestSize(other.denom);
-		big_integer temp = *ptr;
-		while (temp.v.size() < count)
-			temp *= 10;
-		if (ptr = &denom)
-			return (temp == other.denom) ? true : false;
-		else
-			return (denom == temp) ? true : false;
+	return CompareFractions(denom, scale, other.denom, other.scale) == 0;
+}
+
+//	дроби a / 10^aScale и b / 10^bScale: меньший scale дополняется нулями
+int rational::CompareFractions(const big_integer& a, size_t aScale, const big_integer& b, size_t bScale) {
+	if (aScale < bScale) {
+		big_integer temp = a;
+		temp.shift_decimal(bScale - aScale);
+		return big_integer_view::compareMagnitude(temp, b);
+	}
+	if (bScale < aScale) {
+		big_integer temp = b;
+		temp.shift_decimal(aScale - bScale);
+		return big_integer_view::compareMagnitude(a, temp);
+	}
+	return big_integer_view::compareMagnitude(a, b);
+}
+
+//	|*this| == |other| без копий целых частей; дроби выравниваются по scale
+bool rational::EqualMagnitude(const rational& other) const {
+	if (big_integer_view::compareMagnitude(nom, other.nom) != 0)
+		return false;
+	return CompareFractions(denom, scale, other.denom, other.scale) == 0;
+}
+
+void rational::NegateUnlessZero() {
+	if (*this != 0)
+		nom.sign = !nom.sign;
+}
+
+//	целая часть и знак nom, дробная часть ненулевая: значение строго между
+//	nom и следующим от нуля целым
+std::partial_ordering rational::CompareSmall(uint64_t m, bool negative) const {
+	std::strong_ordering temp = big_integer::CompareSmall(nom.view(), m, negative);
+	if (temp != 0 || denom.view().isZero())
+		return temp;
+	return nom.sign ? std::partial_ordering::greater : std::partial_ordering::less;
+}
+
+//	*this += (negative ? -1 : 1) * m. При разных знаках и модуле целой части
+//	меньше m результат берет знак m, целая часть m - |nom| - 1, дробь 1 - дробь
+void rational::AddSmall(uint64_t m, bool negative) {
+	if (m == 0)
+		return;
+	if (denom.view().isZero() || nom.sign != negative) {
+		nom.AddSmall(m, negative);
+		return;
+	}
+	if (nom.SubMagnitude(m))
+		return;
+
+	nom.SubMagnitude(1);
+	nom.sign = !negative;
+	denom = big_integer::pow10(scale) - denom;
+}
+
+//	дробь умножается как целое, ее перенос за 10^scale прибавляется
+//	к целой части; перенос меньше m
+void rational::MulSmall(uint64_t m, bool negative) {
+	if (m == 0) {
+		nom.SetZero();
+		denom.SetZero();
+		scale = 1;
+		return;
+	}
+
+	denom.MulMagnitude(m);
+	big_integer flag;
+	denom.divmod(big_integer::pow10(scale), flag, denom);
+
+	nom.MulMagnitude(m);
+	nom.AddMagnitude(flag.v[0]);
+	nom.sign = (nom.sign != negative);
+	if (nom.view().isZero() && denom.view().isZero())
+		nom.sign = true;
+}
+
+//	деление столбиком: целая часть через divmod_small, затем цифры дроби
+//	и нули за ними, пока остаток не ноль; как и operator/=, не больше 51
+//	ненулевой цифры дроби. rest * 10 + 9 помещается в uint64_t
+void rational::DivSmall(uint64_t m, bool negative) {
+	if (m == 0 || m > UINT64_MAX / 10) {
+		big_integer temp(m);
+		temp.sign = !negative;
+		*this /= rational(temp);
+		return;
 	}
-	return (denom == other.denom) ? true : false;
+
+	constexpr size_t MaxFractionDigits = 51;
+	bool tempSign = nom.sign;
+	uint64_t rest = nom.divmod_small(m);
+
+	bool fraction = !denom.view().isZero();
+	std::string digits = fraction ? this->FractionDigits() : std::string();
+	size_t count = digits.size();
+	std::string ans;
+	size_t nonZero = 0;
+	for (size_t i = 0; nonZero < MaxFractionDigits && (i < count || rest != 0); ++i) {
+		rest = rest * 10 + ((i < count) ? digits[i] - '0' : 0);
+		uint64_t digit = rest / m;
+		rest %= m;
+		ans.push_back(static_cast<char>('0' + digit));
+		if (digit != 0)
+			++nonZero;
+	}
+	while (!ans.empty() && ans.back() == '0')
+		ans.pop_back();
+	this->SetFraction(ans.data(), ans.size());
+
+	nom.sign = (tempSign != negative);
+	if (nom.view().isZero() && ans.empty())
+		nom.sign = true;
 }
 
 rational& rational::operator++() {
@@ -1196,65 +3721,65 @@ rational::operator bool() const {
 
 rational::operator double() const {
 	double res = 0;
-	big_integer count = 1;
+	big_integer count = big_integer::pow10(scale);
 	big_integer temp_nom = nom.Abs();
-	
-	for (size_t i = 0; i < denom.v.size(); ++i) {
-		count *= 10;
-	}
 
-	temp_nom *= count;
+	temp_nom.shift_decimal(scale);
 	temp_nom += denom;
-	
+
 	res = static_cast<double>(temp_nom) / static_cast<double>(count);
 	return (nom.sign ? res : res * -1);
 }
 
 std::string rational::to_string() const {
 	std::string temp = nom.to_string();
+	size_t size = nom.DecimalSize();
+	std::string digits = this->FractionDigits();
 
-	big_integer tempDenom;
+	//	at(i) - i-я цифра дроби от младшей
+	auto at = [&](size_t i) {
+		return (i < scale) ? digits[scale - 1 - i] - '0' : 0;
+	};
 
-	if (denom.v.size() < 16 - nom.v.size())
-		tempDenom = denom;
+	std::string tempDenom;
+
+	if (scale < 16 - size)
+		tempDenom = digits;
 	else {
-		size_t count = 16 - nom.v.size();
-		if (denom.v[count] >= 5) {
-			tempDenom = denom.round(count);
-			size_t i = denom.v.size() - 1;
-
-			tempDenom.reverse();
-			while (i != -1 && tempDenom.v.back() == 0) {
-				tempDenom.v.pop_back();
-				--i;
-			}
-			tempDenom.reverse();
+		size_t count = 16 - size;
+		if (at(count) >= 5) {
+			tempDenom = RoundDigits(digits, count);
+			while (!tempDenom.empty() && tempDenom.back() == '0')
+				tempDenom.pop_back();
 		}
 		else {
-			size_t j = denom.v.size();
+			size_t j = scale;
 			size_t i = j - count - 1;
-			for (; i != j && denom.v[i] == 0; ++i);
+			for (; i != j && at(i) == 0; ++i);
 			if (i == j) {
-				for (; denom.v[count--] == 0;);
-				for (; denom.v[count--] != 0;);
-				tempDenom = denom.round(count - 1);
+				//	первая ненулевая цифра за count и конец ее серии
+				size_t first = digits.find_first_not_of('0', count);
+				size_t end = (first == std::string::npos) ? digits.size() : digits.find('0', first);
+				tempDenom = RoundDigits(digits, (end == std::string::npos) ? digits.size() : end);
 			}
 			else {
-				tempDenom = denom.round(j - i);
+				tempDenom = RoundDigits(digits, j - i);
 			}
 		}
 	}
 
-	if (tempDenom!= 0) {
+	size_t first = tempDenom.find_first_not_of('0');
+	if (first != std::string::npos) {
 		temp.append(".");
-		temp.append(tempDenom.to_string());
+		temp.append(tempDenom, first);
 	}
 	return temp;
 }
 
 double rational::asDecimal(size_t n) const {
-	if (n > 16 - nom.v.size())
-		n = 16 - nom.v.size();
+	size_t size = nom.DecimalSize();
+	if (n > 16 - size)
+		n = 16 - size;
 
 	rational temp = this->round(n);
 	double ans = static_cast<double>(temp);
@@ -1263,144 +3788,85 @@ double rational::asDecimal(size_t n) const {
 	
 //												МЕТОДЫ RATIONAL
 
-void rational::swap(const rational& other) {
+void rational::swap(rational& other) noexcept {
 	nom.swap(other.nom);
 	denom.swap(other.denom);
+	std::swap(scale, other.scale);
 }
 
 rational rational::round(size_t count) const{
-	if (count >= denom.v.size())
+	if (count >= scale)
 		return *this;
 
 	rational rat = 0;
-	size_t index = denom.v.size() - count;
 	rat.nom = this->nom;
-	rat.denom.v.resize(count);
-	memcpy(rat.denom.v.data(), denom.v.data() + index, count);
-
-	if (*(denom.v.end() - count - 1) >= 5) {
-		++rat.denom;
-	}
+	std::string temp = RoundDigits(this->FractionDigits(), count);
+	rat.SetFraction(temp.data(), temp.size());
 	return rat;
 }
 
-rational rational::Abs() const {
-	rational temp = *this;
-	temp.nom.sign = true;
+//	ровно scale цифр дроби, с ведущими нулями
+std::string rational::FractionDigits() const {
+	std::string temp = denom.to_string();
+	if (temp.size() < scale)
+		temp.insert(temp.begin(), scale - temp.size(), '0');
 	return temp;
 }
 
-void rational::evaluate(size_t count, const rational& other) {
-	rational temp = 0;
-	const rational* ptrRat = solutionForNotEqualSize(temp, count, other);
-
-	bool nomSign = nom.sign;
-	bool othernomSign = other.nom.sign;
-	nom.sign = true;
-	ptrRat->nom.sign = true;
-
-	big_integer precious = 1;
-	for (int i = 0; i < count; ++i)
-		precious *= 10;
-
-	if (nomSign == true) {
-		evaluate3(precious, ptrRat, true);
-	}
-	else {
-		evaluate3(precious, ptrRat, false);
-	}
-
-	while (denom.v.size() < count) {
-		denom.v.push_back(0);
-	}
-	other.nom.sign = othernomSign;
+//	count цифр дроби, старшая первой; без цифр дробь - ноль
+void rational::SetFraction(const char* digits, size_t count) {
+	scale = std::max<size_t>(count, 1);
+	if (count == 0)
+		denom = 0;
+	else
+		denom.CheckSignAndWrite(digits, digits + count);
 }
 
-void rational::evaluate2(size_t count, const rational& other, bool b) {
-	big_integer precious = 1;
-	for (int i = 0; i < count; ++i)
-		precious *= 10;
-
-	rational temp = 0;
-	const rational* ptrRat = solutionForNotEqualSize(temp, count, other);
-	
-	if (denom + ptrRat->denom >= precious) {
-		(nom.sign == true) ? ++nom : --nom;
-		denom = denom + ptrRat->denom - precious;
-	}
-	else {
-		denom += ptrRat->denom;
-	}
-
-	(b) ? nom += ptrRat->nom : nom -= ptrRat->nom;
-
-	while (denom.v.size() < count) {
-		denom.v.push_back(0);
-	}
+std::pmr::memory_resource* rational::get_resource() const {
+	return nom.get_resource();
 }
 
-void rational::evaluate3(big_integer& precious, const rational* ptrRat, bool b) {
-	if (*this >= *ptrRat) {
-		if (denom >= ptrRat->denom) {
-			denom -= ptrRat->denom;
-			nom -= ptrRat->nom;
-			nom.sign = (b) ? true : false;
-		}
-		else {
-			denom = denom + precious - ptrRat->denom;
-			nom = nom - 1 - ptrRat->nom;
-			nom.sign = (b) ? true : false;
-		}
-	}
-	else {
-		if (denom >= ptrRat->denom) {
-			denom = ptrRat->denom + precious - denom;
-			nom = ptrRat->nom - 1 - nom;
-			nom.sign = (b) ? false: true;
-		}
-		else {
-			denom = ptrRat->denom - denom;
-			nom = ptrRat->nom - nom;
-			nom.sign = (b) ? false : true;
-		}
-	}
+rational rational::Abs() const {
+	rational temp = *this;
+	temp.nom.sign = true;
+	return temp;
 }
 
-const rational* rational::solutionForNotEqualSize(rational& temp , size_t count, const rational& other) {
-	const big_integer* ptr = denom.getSmallestSize(other.denom);
-	const rational* ptrRat = nullptr;
-
-	if (ptr == &(denom)) {
-		while (denom.v.size() < count)
-			denom *= 10;
-		ptrRat = &other;
-	}
-	else {
-		temp = other;
-		while (temp.denom.v.size() < count)
-			temp.denom *= 10;
-		ptrRat = &temp;
-	}
-	return ptrRat;
+//	оба слагаемых переводятся в целые с count дробными цифрами,
+//	складываются или вычитаются и делятся обратно
+void rational::evaluate(size_t count, const rational& other, bool add) {
+	big_integer a = nom.join(denom, scale);
+	big_integer b = other.nom.join(other.denom, other.scale);
+	a.shift_decimal(count - scale);
+	b.shift_decimal(count - other.scale);
+	if (add)
+		a += b;
+	else
+		a -= b;
+	*this = a.disjoin(count);
 }
 
+//	цифры дробной части a / b (a < b) до 51-й ненулевой включительно;
+//	делит сразу блоками по FractionChunk цифр вместо сдвига на одну цифру
 void rational::evaluateForDivide(big_integer& a, big_integer& b, std::vector<int>& ans) {
+	constexpr size_t FractionChunk = 64;
 	size_t count = 0;
-	size_t item = 0;
 
 	while (a != 0 && count < 51) {
-		while (a < b) {
-			a *= 10;
-			++item;
-			if (item >= 2)
-				ans.push_back(0);
+		a.shift_decimal(FractionChunk);
+		big_integer temp;
+		a.divmod(b, temp, a);
+		std::string digits = temp.to_string();
+		digits.insert(digits.begin(), FractionChunk - digits.size(), '0');
+		for (size_t i = 0; i < FractionChunk && count < 51; ++i) {
+			int digit = digits[i] - '0';
+			ans.push_back(digit);
+			if (digit != 0)
+				++count;
 		}
-		item = 0;
-		++count;
-		int temp = static_cast<int>(a / b);
-		ans.push_back(temp);
-		a %= b;
 	}
+	while (!ans.empty() && ans.back() == 0)
+		ans.pop_back();
 }
 
 
@@ -1,14 +1,201 @@
-﻿
+﻿#pragma once
+
 #include<vector>
+#include<cstdint>
+#include<cstddef>
 #include<string>
 #include<iostream>
+#include<utility>
+#include<compare>
+#include<concepts>
+#include<stdexcept>
+#include<memory_resource>
+#include<bit>
+#include<charconv>
 
 class rational;
+class big_integer;
+
+//                                         ХРАНЕНИЕ ЦИФР
+//	Вектор 64-битных лимбов (цифр по основанию 2^64, младший первым) со
+//	встроенным буфером: до InlineCapacity лимбов (256 бит) лежат в самом
+//	объекте, куча нужна только при росте. Интерфейс повторяет используемую
+//	часть std::vector<uint64_t>. Куча берется из std::pmr::memory_resource.
+//	Как у pmr-контейнеров, новый буфер и копия получают текущий ресурс потока
+//	(digit_resource_scope::current), а не ресурс оригинала. Перемещающий
+//	конструктор забирает буфер вместе с ресурсом; перемещающее присваивание
+//	забирает его только при равных ресурсах, иначе копирует лимбы и может
+//	бросить bad_alloc. swap обменивает и ресурсы
+class digit_buffer {
+public:
+	using iterator = uint64_t*;
+	using const_iterator = const uint64_t*;
+	static constexpr size_t InlineCapacity = 4;
+
+	digit_buffer() noexcept;
+	explicit digit_buffer(std::pmr::memory_resource*) noexcept;
+	digit_buffer(const digit_buffer&);
+	digit_buffer(const digit_buffer&, std::pmr::memory_resource*);
+	digit_buffer(digit_buffer&&) noexcept;
+	digit_buffer& operator=(const digit_buffer&);
+	digit_buffer& operator=(digit_buffer&&);
+	~digit_buffer();
+
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+	size_t capacity() const { return cap; }
+	bool isInline() const { return ptr == local; }
+	std::pmr::memory_resource* resource() const { return res; }
+
+	uint64_t* data() { return ptr; }
+	const uint64_t* data() const { return ptr; }
+	uint64_t& operator[](size_t i) { return ptr[i]; }
+	uint64_t operator[](size_t i) const { return ptr[i]; }
+	uint64_t& front() { return ptr[0]; }
+	uint64_t front() const { return ptr[0]; }
+	uint64_t& back() { return ptr[count - 1]; }
+	uint64_t back() const { return ptr[count - 1]; }
+
+	iterator begin() { return ptr; }
+	iterator end() { return ptr + count; }
+	const_iterator begin() const { return ptr; }
+	const_iterator end() const { return ptr + count; }
+
+	void push_back(uint64_t d) {
+		if (count == cap)
+			Grow(count + 1);
+		ptr[count++] = d;
+	}
+	void pop_back() { --count; }
+	void clear() { count = 0; }
+
+	void resize(size_t, uint64_t = 0);
+	void reserve(size_t);
+	void shrink_to_fit();
+	iterator insert(const_iterator, size_t, uint64_t);
+	iterator insert(const_iterator, const_iterator, const_iterator);
+	iterator erase(const_iterator, const_iterator);
+	void assign(const_iterator, const_iterator);
+	void swap(digit_buffer&) noexcept;
+
+private:
+	void Grow(size_t);
+	void Release();
+
+	uint64_t* ptr;
+	size_t count = 0;
+	size_t cap = InlineCapacity;
+	std::pmr::memory_resource* res;
+	uint64_t local[InlineCapacity];
+};
+
+//                                         РЕСУРСЫ ПАМЯТИ
+//	Монотонная арена: освобождение отдельных буферов ничего не делает,
+//	release() или деструктор возвращают всю память сразу
+class digit_arena : public std::pmr::monotonic_buffer_resource {
+public:
+	static constexpr size_t DefaultSize = 1 << 20;
+
+	explicit digit_arena(size_t = DefaultSize, std::pmr::memory_resource* = std::pmr::get_default_resource());
+};
+
+//	Пул по классам размеров 2^k от MinBlock до MaxBlock: освобожденный буфер
+//	попадает в список своего класса и отдается следующему запросу того же класса.
+//	Блоки нарезаются из кусков upstream; больше MaxBlock идут в upstream напрямую.
+//	Не потокобезопасен. Поверх digit_arena дает переиспользование временных
+//	буферов и освобождение всего вычисления за один release() арены
+class digit_pool_resource : public std::pmr::memory_resource {
+public:
+	static constexpr size_t MinBlock = 64;
+	static constexpr size_t MaxBlock = 1 << 20;
+	static constexpr size_t ChunkSize = 1 << 16;
+
+	explicit digit_pool_resource(std::pmr::memory_resource* = std::pmr::get_default_resource());
+	digit_pool_resource(const digit_pool_resource&) = delete;
+	digit_pool_resource& operator=(const digit_pool_resource&) = delete;
+	~digit_pool_resource();
+
+	void release();
+	std::pmr::memory_resource* upstream_resource() const;
+
+private:
+	void* do_allocate(size_t, size_t) override;
+	void do_deallocate(void*, size_t, size_t) override;
+	bool do_is_equal(const std::pmr::memory_resource&) const noexcept override;
+
+	static size_t SizeClass(size_t);
+
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+	struct Chunk {
+		Chunk* next;
+		size_t size;
+	};
+	static constexpr size_t ClassCount = 15;
+	static constexpr size_t BlockAlign = alignof(std::max_align_t);
+	static constexpr size_t ChunkHeader = (sizeof(Chunk) + BlockAlign - 1) / BlockAlign * BlockAlign;
+
+	std::pmr::memory_resource* upstream;
+	FreeBlock* freeLists[ClassCount] = {};
+	Chunk* chunks = nullptr;
+	char* cursor = nullptr;
+	char* limit = nullptr;
+};
+
+//	на время жизни объекта делает ресурс текущим для цифр своего потока, так что
+//	все временные числа вычисления берут память из него. Другие потоки и
+//	std::pmr::get_default_resource() не затрагиваются; вне областей текущим
+//	считается ресурс по умолчанию
+class digit_resource_scope {
+public:
+	explicit digit_resource_scope(std::pmr::memory_resource*);
+	digit_resource_scope(const digit_resource_scope&) = delete;
+	digit_resource_scope& operator=(const digit_resource_scope&) = delete;
+	~digit_resource_scope();
+
+	static std::pmr::memory_resource* current() noexcept;
+
+private:
+	std::pmr::memory_resource* previous;
+};
+
+//                                         ПРЕДСТАВЛЕНИЕ БЕЗ ВЛАДЕНИЯ
+//	Указатель на лимбы, их число и знак. Лимбы не копируются, поэтому
+//	представление действительно, пока исходное число не изменено.
+//	Ведущих нулевых лимбов нет; у нуля один лимб
+class big_integer_view {
+public:
+	big_integer_view(const big_integer&);
+
+	size_t size() const;
+	uint64_t operator[](size_t) const;
+	const uint64_t* data() const;
+	bool getSign() const;
+	bool isZero() const;
+
+	big_integer_view abs() const;
+	big_integer_view operator-() const;
+
+	friend bool operator==(big_integer_view, big_integer_view);
+	friend std::strong_ordering operator<=>(big_integer_view, big_integer_view);
+	static int compareMagnitude(big_integer_view, big_integer_view);
+
+private:
+	big_integer_view(const uint64_t*, size_t, bool);
+	friend class big_integer;
+
+	const uint64_t* digits;
+	size_t length;
+	bool sign;
+};
 
 class big_integer {
 private:
 	bool sign = true;
-	std::vector<int8_t> v;
+	//	цифры по основанию 2^64, младшая первой; ведущих нулевых лимбов нет,
+	//	у нуля один лимб
+	digit_buffer v;
 public:
 	big_integer();
 	big_integer(int);
@@ -19,10 +206,25 @@ public:
 	big_integer(unsigned long long);
 	big_integer(const char*);
 	explicit big_integer(const std::string&);
+	big_integer(const char*, int);
+	big_integer(const std::string&, int);
 	big_integer(const std::vector<int>&);
 	big_integer(const big_integer&);
+	big_integer(big_integer&&) noexcept;
+	explicit big_integer(big_integer_view);
+	explicit big_integer(std::pmr::memory_resource*);
+	big_integer(const big_integer&, std::pmr::memory_resource*);
 	big_integer(double);
 	big_integer& operator=(const big_integer&);
+	big_integer& operator=(big_integer&&);
+
+	//	вычисление ленивого выражения из Big_integer_Rational_lazy.h
+	template<typename E>
+		requires requires(const E& e, big_integer& x) { e.assign_to(x); }
+	big_integer(const E& e): big_integer() { e.assign_to(*this); }
+	template<typename E>
+		requires requires(const E& e, big_integer& x) { e.assign_to(x); }
+	big_integer& operator=(const E& e) { e.assign_to(*this); return *this; }
 
 	friend std::ostream& operator<<(std::ostream&, const big_integer&);
 	friend std::istream& operator>>(std::istream&, big_integer&);
@@ -35,6 +237,7 @@ public:
 
 	friend bool operator==(const big_integer&, const big_integer&);
 	friend bool operator!=(const big_integer&, const big_integer&);
+	friend std::strong_ordering operator<=>(const big_integer&, const big_integer&);
 
 	friend big_integer operator+(const big_integer&, const big_integer&);
 	friend big_integer operator*(const big_integer&, const big_integer&);
@@ -42,8 +245,29 @@ public:
 	friend big_integer operator%(const big_integer&, const big_integer&);
 	friend big_integer operator-(const big_integer&, const big_integer&);
 
+	//	временный операнд отдает свой буфер под результат
+	friend big_integer operator+(big_integer&&, const big_integer&);
+	friend big_integer operator+(const big_integer&, big_integer&&);
+	friend big_integer operator+(big_integer&&, big_integer&&);
+	friend big_integer operator-(big_integer&&, const big_integer&);
+	friend big_integer operator*(big_integer&&, const big_integer&);
+	friend big_integer operator*(const big_integer&, big_integer&&);
+	friend big_integer operator*(big_integer&&, big_integer&&);
+
+	//	сравнение с машинным словом как с одним лимбом, без построения big_integer
+	template<std::integral T>
+	friend std::strong_ordering operator<=>(const big_integer&, T);
+	template<std::integral T>
+	friend std::partial_ordering operator<=>(const rational&, T);
+	template<std::integral T>
+	friend big_integer operator-(T, const big_integer&);
+	//	остаток от деления на машинное слово читает делимое, не копируя его
+	template<std::integral T>
+	friend big_integer operator%(const big_integer&, T);
+
 	friend class rational;
 	friend std::ostream& operator<<(std::ostream&, const rational&);
+	friend std::istream& operator>>(std::istream&, rational&);
 
 	big_integer& operator++();
 	big_integer operator++(int);
@@ -56,6 +280,34 @@ public:
 	big_integer& operator/=(const big_integer& b);
 	big_integer& operator%=(const big_integer&);
 	big_integer& operator-=(const big_integer&);
+	big_integer& operator+=(big_integer_view);
+	big_integer& operator-=(big_integer_view);
+	big_integer& square();
+
+	//	*this += a * b и *this -= a * b без промежуточного произведения
+	big_integer& addmul(const big_integer&, const big_integer&);
+	big_integer& submul(const big_integer&, const big_integer&);
+	big_integer& addmul_small(const big_integer&, uint64_t);
+	big_integer& submul_small(const big_integer&, uint64_t);
+
+	void divmod(const big_integer&, big_integer&, big_integer&) const;
+	std::pair<big_integer, big_integer> divmod(const big_integer&) const;
+
+	template<std::integral T>
+	big_integer& operator+=(T);
+	template<std::integral T>
+	big_integer& operator-=(T);
+	template<std::integral T>
+	big_integer& operator*=(T);
+	template<std::integral T>
+	big_integer& operator/=(T);
+	template<std::integral T>
+	big_integer& operator%=(T);
+	//	*this /= d, возвращает модуль остатка; любой d != 0
+	uint64_t divmod_small(uint64_t);
+
+	class modulus_context;
+	class workspace;
 
 	bool operator!() const;
 	big_integer operator-();
@@ -66,32 +318,133 @@ public:
 	explicit operator double() const;
 
 	std::string to_string() const;
+	std::string to_string(int) const;
 	big_integer Abs() const;
+	big_integer_view view() const;
+	std::pmr::memory_resource* get_resource() const;
+	void reserve(size_t);
 	big_integer& reverse();
 	big_integer round(size_t) const;
-	void swap(big_integer);
 
-private:
-	void CheckSignAndWrite(const char*);
-	void HelperForCheckSingAndWrite(const char*, int);
-	int CheckSignForChar(const char*);
-	void HelperToString(std::string&) const;
-	template<typename T>
-	void CheckSignForOut(T&) const;
+	//	умножение и деление на 10^k; степени 10^(2^i) кэшируются в потоке
+	big_integer& shift_decimal(size_t);
+	big_integer& unshift_decimal(size_t);
+	static big_integer pow10(size_t);
+	void swap(big_integer&) noexcept;
+
+	//	разбор и запись без исключений, в духе std::from_chars / std::to_chars;
+	//	основания от 2 до 36. При ошибке разбора value не меняется. Память
+	//	берется только под сам результат (до 4 лимбов - ни байта), кроме
+	//	оснований не степеней двойки: разбор длиннее 1024 десятичных цифр
+	//	(64 слов-кусков) и запись длиннее 4 лимбов берут временную память
+	//	потока, а ее нехватка возвращает errc::not_enough_memory
+	static std::from_chars_result from_chars(const char*, const char*, big_integer&, int = 10) noexcept;
+	static std::to_chars_result to_chars(char*, char*, const big_integer&, int = 10) noexcept;
+
+	//	наборы ядер десятичного перевода; по умолчанию берется лучший из тех,
+	//	что поддерживает процессор. Переключение действует на весь процесс и
+	//	нужно, чтобы сравнить ядра между собой; false, если набор недоступен
+	enum class digit_kernels { scalar, sse2, sse41, avx2 };
+	static bool select_digit_kernels(digit_kernels);
+	static digit_kernels current_digit_kernels();
 
-	void PredSummer(const big_integer&);
-	void Summer(size_t, size_t, const big_integer&, bool Ifsmaller, size_t = 0);
-	void HelperForSummer(int&, size_t, int = 0);
+private:
+	void CheckSignAndWrite(const char*, const char*, int = 10);
+	static void WriteNumber(std::ostream&, bool, const big_integer&, const big_integer*, size_t);
 
-	void PredDestr(const big_integer&, size_t&);
-	void Destructer(const big_integer&, size_t, size_t, size_t&, bool);
-	void HelperDestructer1(const big_integer&, int&, size_t&, bool);
-	void HelperDestructer2(const big_integer&, int&, size_t&, bool);
+	void PredSummer(big_integer_view);
+	void PredDestr(big_integer_view, bool);
+	bool Aliases(big_integer_view) const;
+	void SetZero();
 
 	void Multiply(const big_integer& a, const big_integer& b);
-	bool HelperForMemcmp(const big_integer&, const big_integer&) const;
+	bool MultiplyInline(const big_integer&, const big_integer&);
+	void DivMod(const big_integer&, big_integer*, big_integer*) const;
+	bool DivModInline(const big_integer&, big_integer*, big_integer*) const;
 
-	bool HelperForOperatorLowandBig(const big_integer&, const big_integer&) const;
+	//	временные векторы ядер берут блоки из кэша текущего workspace потока
+	template<typename T>
+	struct ScratchAllocator {
+		using value_type = T;
+
+		ScratchAllocator() = default;
+		template<typename U>
+		ScratchAllocator(const ScratchAllocator<U>&) {}
+
+		T* allocate(size_t n) { return static_cast<T*>(ScratchAllocate(n * sizeof(T))); }
+		void deallocate(T* p, size_t n) { ScratchFree(p, n * sizeof(T)); }
+		friend bool operator==(const ScratchAllocator&, const ScratchAllocator&) { return true; }
+	};
+	static void* ScratchAllocate(size_t);
+	static void ScratchFree(void*, size_t);
+	static workspace* CurrentWorkspace();
+
+	//	лимб - цифра по основанию 2^64; произведение двух лимбов берется
+	//	целиком через unsigned __int128 или интринсики
+	using limb = uint64_t;
+	using limbs = std::vector<limb, ScratchAllocator<limb>>;
+	//	вычеты по простым модулям NTT
+	using residues = std::vector<uint32_t, ScratchAllocator<uint32_t>>;
+	static constexpr unsigned LimbBits = 64;
+
+	template<std::integral T>
+	static uint64_t SmallMagnitude(T, bool&);
+	static std::strong_ordering CompareSmall(big_integer_view, uint64_t, bool);
+	static uint64_t RemainderSmall(big_integer_view, uint64_t);
+	void AddSmall(uint64_t, bool);
+	void MulSmall(uint64_t, bool);
+	void AddMagnitude(uint64_t);
+	bool SubMagnitude(uint64_t);
+	void MulMagnitude(uint64_t);
+
+	limbs ToLimbs() const;
+
+	static void MulSchoolbook(const limb*, size_t, const limb*, size_t, limb*);
+	static void SqrSchoolbook(const limb*, size_t, limb*);
+
+	static constexpr size_t KaratsubaThreshold = 32;
+	static constexpr size_t Toom3Threshold = 128;
+	static constexpr size_t NttThreshold = 8192;
+	static constexpr size_t NttMaxSize = size_t(1) << 21;
+	static constexpr size_t BurnikelThreshold = 64;
+	static constexpr size_t ReciprocalThreshold = 128;
+
+	static void MulLimbs(const limb*, size_t, const limb*, size_t, limb*);
+	static void MulKaratsuba(const limb*, size_t, const limb*, size_t, limb*);
+	static void MulUnbalanced(const limb*, size_t, const limb*, size_t, limb*);
+	static void MulToom3(const limb*, size_t, const limb*, size_t, limb*);
+	static void MulNtt(const limb*, size_t, const limb*, size_t, limb*);
+	template<uint32_t Mod>
+	static void NttConvolution(const limb*, size_t, const limb*, size_t, residues&);
+	template<uint32_t Mod>
+	static void Ntt(residues&, bool);
+	static void ToomEvaluate(const limb*, size_t, size_t, limbs&, limbs&, bool&, limbs&, bool&);
+	static void MulSigned(const limbs&, bool, const limbs&, bool, limbs&, bool&);
+	static void AddSigned(limbs&, bool&, const limbs&, bool);
+	static void DivExact3(limbs&);
+	static void Halve(limbs&);
+	static void Trim(limbs&);
+	static int CompareLimbs(const limb*, size_t, const limb*, size_t);
+	static void DivModLimbs(limbs, limbs, limbs&, limbs&);
+	static void DivideLimbs(limbs, limbs, limbs&, limbs&);
+	static void DivideBurnikel(limbs, limbs, limbs&, limbs&);
+	static void Div2n1n(const limbs&, const limbs&, size_t, limbs&, limbs&);
+	static void Div3n2n(const limbs&, const limbs&, size_t, limbs&, limbs&);
+	static limbs Slice(const limbs&, size_t, size_t);
+	static limb DivSmallLimbs(limbs&, limb);
+	static limb ShiftLeft(limb*, size_t, unsigned);
+	static void ShiftRight(limb*, size_t, unsigned);
+	void TrimDigits();
+	void NegateUnlessZero();
+	void AssignSmall(uint64_t, bool);
+	void AssignLimbs(const limbs&, bool);
+	static limb AddTo(limb*, size_t, const limb*, size_t);
+	static limb SubFrom(limb*, size_t, const limb*, size_t);
+	static limb AddMul1(limb*, const limb*, size_t, limb);
+	static limb SubMul1(limb*, const limb*, size_t, limb);
+	void MulAccumulate(const limb*, size_t, const limb*, size_t, bool);
+	size_t BitSize() const;
+	size_t DecimalSize() const;
 
 	void HelperForCtorFromDouble(double);
 
@@ -99,23 +452,259 @@ private:
 	void evaluate(T);
 
 	bool getSign() const;
-	const big_integer* getbiggerSize(const big_integer&) const;
-	const big_integer* getSmallestSize(const big_integer&) const;
-	big_integer join(const big_integer&) const;
+	big_integer join(const big_integer&, size_t) const;
 	rational disjoin(size_t);
 };
-//                                         ОБЪЯВЛЕНИЯ СПЕЦИАЛИЗАЦИЙ
-template<>
-void big_integer::CheckSignForOut(std::string&) const;
-template<>
-void big_integer::CheckSignForOut(std::ostream&) const;
 
+//                                         РАБОЧАЯ ПАМЯТЬ
+//	Кэш блоков под временные лимбы умножения и деления: освобожденный блок
+//	попадает в список своего класса размера 2^k и отдается следующему запросу.
+//	У каждого потока есть свой кэш; объект workspace на время жизни подменяет
+//	его собственным, а деструктор возвращает накопленные блоки в кучу. Цикл
+//	с операндами одного размера после первой итерации к куче не обращается.
+//	Вложенные workspace одного потока разрушаются в обратном порядке
+class big_integer::workspace {
+public:
+	workspace();
+	workspace(const workspace&) = delete;
+	workspace& operator=(const workspace&) = delete;
+	~workspace();
+
+	void release();
+	size_t cached() const;
+
+private:
+	friend class big_integer;
+	struct ThreadDefault {};
+	explicit workspace(ThreadDefault);
+
+	void* Allocate(size_t);
+	void Free(void*, size_t);
+	static size_t SizeClass(size_t);
+
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+	static constexpr size_t MinBlock = 64;
+	static constexpr size_t ClassCount = 21;
+	static constexpr size_t MaxBlock = MinBlock << (ClassCount - 1);
+	static constexpr size_t MaxCached = size_t(1) << 26;
+
+	FreeBlock* freeLists[ClassCount] = {};
+	size_t cachedBytes = 0;
+	workspace* previous = nullptr;
+	bool pinned;
+};
+
+//                                         ФИКСИРОВАННЫЙ МОДУЛЬ
+//	Предвычисления для многократного взятия остатка по одному модулю:
+//	обратная величина Барретта для reduce, divmod и mul, форма Монтгомери для pow,
+//	если модуль нечетный (взаимно прост с основанием лимбов 2^64). Знаки
+//	результатов такие же, как у operator%=: остаток берет знак делимого
+class big_integer::modulus_context {
+public:
+	explicit modulus_context(const big_integer&);
+
+	big_integer reduce(const big_integer&) const;
+	std::pair<big_integer, big_integer> divmod(const big_integer&) const;
+	big_integer mul(const big_integer&, const big_integer&) const;
+	big_integer pow(const big_integer&, const big_integer&) const;
+	const big_integer& modulus() const;
+
+private:
+	big_integer m;
+	limbs mod;
+	limbs mu;
+	size_t k = 0;
+
+	bool montgomery = false;
+	limb minv = 0;
+	limbs r2;
+
+	static limbs Reciprocal(const limbs&);
+	void DivLimbs(limbs, limbs&, limbs&) const;
+	limbs ReduceLimbs(limbs) const;
+	limbs MulMod(const limbs&, const limbs&) const;
+	limbs Redc(limbs) const;
+	limbs MontMul(const limbs&, const limbs&) const;
+	limbs PowLimbs(const limbs&, const big_integer&) const;
+};
 
+//                                         ОПЕРАЦИИ С МАШИННЫМ СЛОВОМ
+//	Операнд целого типа не превращается в big_integer: сложение и вычитание
+//	проходят по лимбам только до затухания переноса, умножение - один проход
+//	с произведением двойной ширины, сравнение - с одним лимбом на стеке
+
+//	модуль и знак; модуль INT64_MIN тоже помещается в uint64_t
+template<std::integral T>
+uint64_t big_integer::SmallMagnitude(T b, bool& negative) {
+	negative = false;
+	uint64_t d = static_cast<uint64_t>(b);
+	if constexpr (std::is_signed_v<T>) {
+		negative = b < 0;
+		d = negative ? 0 - d : d;
+	}
+	return d;
+}
+
+template<std::integral T>
+big_integer& big_integer::operator+=(T b) {
+	bool negative;
+	uint64_t d = SmallMagnitude(b, negative);
+	this->AddSmall(d, negative);
+	return *this;
+}
+
+template<std::integral T>
+big_integer& big_integer::operator-=(T b) {
+	bool negative;
+	uint64_t d = SmallMagnitude(b, negative);
+	this->AddSmall(d, !negative);
+	return *this;
+}
+
+template<std::integral T>
+big_integer& big_integer::operator*=(T b) {
+	bool negative;
+	uint64_t d = SmallMagnitude(b, negative);
+	this->MulSmall(d, negative);
+	return *this;
+}
+
+template<std::integral T>
+big_integer operator+(const big_integer& a, T b) {
+	big_integer temp = a;
+	temp += b;
+	return temp;
+}
+
+template<std::integral T>
+big_integer operator+(big_integer&& a, T b) {
+	a += b;
+	return std::move(a);
+}
+
+template<std::integral T>
+big_integer operator+(T a, const big_integer& b) {
+	return b + a;
+}
+
+template<std::integral T>
+big_integer operator+(T a, big_integer&& b) {
+	return std::move(b) + a;
+}
+
+template<std::integral T>
+big_integer operator-(const big_integer& a, T b) {
+	big_integer temp = a;
+	temp -= b;
+	return temp;
+}
+
+template<std::integral T>
+big_integer operator-(big_integer&& a, T b) {
+	a -= b;
+	return std::move(a);
+}
+
+template<std::integral T>
+big_integer operator-(T a, const big_integer& b) {
+	big_integer temp = b;
+	temp.NegateUnlessZero();
+	temp += a;
+	return temp;
+}
+
+template<std::integral T>
+big_integer operator*(const big_integer& a, T b) {
+	big_integer temp = a;
+	temp *= b;
+	return temp;
+}
+
+template<std::integral T>
+big_integer operator*(big_integer&& a, T b) {
+	a *= b;
+	return std::move(a);
+}
+
+template<std::integral T>
+big_integer operator*(T a, const big_integer& b) {
+	return b * a;
+}
+
+template<std::integral T>
+big_integer operator*(T a, big_integer&& b) {
+	return std::move(b) * a;
+}
+
+template<std::integral T>
+std::strong_ordering operator<=>(const big_integer& a, T b) {
+	bool negative;
+	uint64_t d = big_integer::SmallMagnitude(b, negative);
+	return big_integer::CompareSmall(a.view(), d, negative);
+}
+
+template<std::integral T>
+bool operator==(const big_integer& a, T b) {
+	return (a <=> b) == 0;
+}
+
+//                                         ДЕЛЕНИЕ НА МАШИННОЕ СЛОВО
+template<std::integral T>
+big_integer& big_integer::operator/=(T b) {
+	if (b == 0)
+		throw std::invalid_argument("division by zero");
+
+	bool negative;
+	uint64_t d = SmallMagnitude(b, negative);
+	this->divmod_small(d);
+	if (negative)
+		this->NegateUnlessZero();
+	return *this;
+}
+
+template<std::integral T>
+big_integer& big_integer::operator%=(T b) {
+	if (b == 0)
+		throw std::invalid_argument("division by zero");
+
+	bool negative;
+	uint64_t d = SmallMagnitude(b, negative);
+	bool tempSign = sign;
+	this->AssignSmall(this->divmod_small(d), tempSign);
+	return *this;
+}
+
+template<std::integral T>
+big_integer operator/(const big_integer& a, T b) {
+	big_integer temp = a;
+	temp /= b;
+	return temp;
+}
+
+template<std::integral T>
+big_integer operator%(const big_integer& a, T b) {
+	if (b == 0)
+		throw std::invalid_argument("division by zero");
+
+	bool negative;
+	uint64_t d = big_integer::SmallMagnitude(b, negative);
+	big_integer temp;
+	temp.AssignSmall(big_integer::RemainderSmall(a.view(), d), a.sign);
+	return temp;
+}
+
+
+//	Значение - nom + denom / 10^scale со знаком nom: denom хранит дробные
+//	цифры как целое, а их число, включая ведущие нули дроби, задает scale.
+//	У -0.5 целая часть - ноль со знаком минус
 class rational
 {
 private:
 	mutable big_integer nom;
 	mutable big_integer denom;
+	size_t scale = 1;
 
 public:
 	rational();
@@ -124,9 +713,20 @@ public:
 	rational(int);
 	rational(double);
 	rational(const rational&);
+	rational(rational&&) noexcept;
+	explicit rational(std::pmr::memory_resource*);
+	rational(const rational&, std::pmr::memory_resource*);
 	explicit rational(const std::string&);
 	rational(const char*);
 	rational& operator=(const rational&);
+	rational& operator=(rational&&);
+
+	template<typename E>
+		requires requires(const E& e, rational& x) { e.assign_to(x); }
+	rational(const E& e): rational() { e.assign_to(*this); }
+	template<typename E>
+		requires requires(const E& e, rational& x) { e.assign_to(x); }
+	rational& operator=(const E& e) { e.assign_to(*this); return *this; }
 
 	friend std::ostream& operator<<(std::ostream&, const rational&);
 	friend std::istream& operator>>(std::istream&, rational&);
@@ -136,11 +736,34 @@ public:
 	friend rational operator*(const rational&, const rational&);
 	friend rational operator/(const rational&, const rational&);
 
+	friend rational operator+(rational&&, const rational&);
+	friend rational operator+(const rational&, rational&&);
+	friend rational operator+(rational&&, rational&&);
+	friend rational operator-(rational&&, const rational&);
+	friend rational operator*(rational&&, const rational&);
+	friend rational operator*(const rational&, rational&&);
+	friend rational operator*(rational&&, rational&&);
+	friend rational operator/(rational&&, const rational&);
+
+	template<std::integral T>
+	friend std::partial_ordering operator<=>(const rational&, T);
+	template<std::integral T>
+	friend rational operator-(T, const rational&);
+
 	rational& operator+=(const rational&);
 	rational& operator-=(const rational&);
 	rational& operator*=(const rational&);
 	rational& operator/=(const rational&);
 
+	template<std::integral T>
+	rational& operator+=(T);
+	template<std::integral T>
+	rational& operator-=(T);
+	template<std::integral T>
+	rational& operator*=(T);
+	template<std::integral T>
+	rational& operator/=(T);
+
 	bool operator==(const rational&) const;
 	std::partial_ordering operator<=>(const rational&) const;
 
@@ -161,14 +784,161 @@ public:
 
 	rational round(size_t) const;
 	rational Abs() const;
+	std::pmr::memory_resource* get_resource() const;
 
-	void swap(const rational&);
+	void swap(rational&) noexcept;
 
 private:
-	void evaluate(size_t, const rational&);
-	void evaluate2(size_t, const rational&, bool);
-	void evaluate3(big_integer&, const rational*, bool);
+	friend class big_integer;
+
+	void evaluate(size_t, const rational&, bool);
 	void evaluateForDivide(big_integer&, big_integer&, std::vector<int>&);
-	const rational* solutionForNotEqualSize(rational& ,size_t, const rational&);
+	bool EqualMagnitude(const rational&) const;
+	void CheckPointAndWrite(const char*, const char*);
+	static int CompareFractions(const big_integer&, size_t, const big_integer&, size_t);
+	std::string FractionDigits() const;
+	void SetFraction(const char*, size_t);
+
+	void NegateUnlessZero();
+	void AddSmall(uint64_t, bool);
+	void MulSmall(uint64_t, bool);
+	void DivSmall(uint64_t, bool);
+	std::partial_ordering CompareSmall(uint64_t, bool) const;
 };
 
+//                                         RATIONAL И МАШИННОЕ СЛОВО
+//	Целая часть меняется ядрами big_integer, дробные цифры - на месте,
+//	без построения rational из операнда
+template<std::integral T>
+rational& rational::operator+=(T b) {
+	bool negative;
+	uint64_t d = big_integer::SmallMagnitude(b, negative);
+	this->AddSmall(d, negative);
+	return *this;
+}
+
+template<std::integral T>
+rational& rational::operator-=(T b) {
+	bool negative;
+	uint64_t d = big_integer::SmallMagnitude(b, negative);
+	this->AddSmall(d, !negative);
+	return *this;
+}
+
+template<std::integral T>
+rational& rational::operator*=(T b) {
+	bool negative;
+	uint64_t d = big_integer::SmallMagnitude(b, negative);
+	this->MulSmall(d, negative);
+	return *this;
+}
+
+template<std::integral T>
+rational& rational::operator/=(T b) {
+	bool negative;
+	uint64_t d = big_integer::SmallMagnitude(b, negative);
+	this->DivSmall(d, negative);
+	return *this;
+}
+
+template<std::integral T>
+rational operator+(const rational& a, T b) {
+	rational temp = a;
+	temp += b;
+	return temp;
+}
+
+template<std::integral T>
+rational operator+(rational&& a, T b) {
+	a += b;
+	return std::move(a);
+}
+
+template<std::integral T>
+rational operator+(T a, const rational& b) {
+	return b + a;
+}
+
+template<std::integral T>
+rational operator+(T a, rational&& b) {
+	return std::move(b) + a;
+}
+
+template<std::integral T>
+rational operator-(const rational& a, T b) {
+	rational temp = a;
+	temp -= b;
+	return temp;
+}
+
+template<std::integral T>
+rational operator-(rational&& a, T b) {
+	a -= b;
+	return std::move(a);
+}
+
+template<std::integral T>
+rational operator-(T a, const rational& b) {
+	rational temp = b;
+	temp.NegateUnlessZero();
+	temp += a;
+	return temp;
+}
+
+template<std::integral T>
+rational operator*(const rational& a, T b) {
+	rational temp = a;
+	temp *= b;
+	return temp;
+}
+
+template<std::integral T>
+rational operator*(rational&& a, T b) {
+	a *= b;
+	return std::move(a);
+}
+
+template<std::integral T>
+rational operator*(T a, const rational& b) {
+	return b * a;
+}
+
+template<std::integral T>
+rational operator*(T a, rational&& b) {
+	return std::move(b) * a;
+}
+
+template<std::integral T>
+rational operator/(const rational& a, T b) {
+	rational temp = a;
+	temp /= b;
+	return temp;
+}
+
+template<std::integral T>
+rational operator/(rational&& a, T b) {
+	a /= b;
+	return std::move(a);
+}
+
+template<std::integral T>
+rational operator/(T a, const rational& b) {
+	rational temp(b.get_resource());
+	temp += a;
+	temp /= b;
+	return temp;
+}
+
+template<std::integral T>
+std::partial_ordering operator<=>(const rational& a, T b) {
+	bool negative;
+	uint64_t d = big_integer::SmallMagnitude(b, negative);
+	return a.CompareSmall(d, negative);
+}
+
+template<std::integral T>
+bool operator==(const rational& a, T b) {
+	return (a <=> b) == 0;
+}
+
+
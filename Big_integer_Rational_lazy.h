@@ -0,0 +1,318 @@
+﻿#pragma once
+
+#include "Big_integer_Rational.h"
+
+#include<type_traits>
+#include<algorithm>
+
+//                                         ЛЕНИВЫЕ ВЫРАЖЕНИЯ
+//	Подключаются отдельно. lazy(x) начинает выражение, +, - и * только строят
+//	дерево ссылок на операнды; вычисление происходит при присваивании числу.
+//	Результат сразу получает буфер нужного размера, слагаемые добавляются к нему
+//	на месте, а произведения big_integer идут через addmul/submul без временных:
+//		big_integer r = lazy(a) * b + lazy(c) * d - e;
+//	Выражение держит ссылки, поэтому его вычисляют в том же полном выражении,
+//	где оно построено, и не сохраняют в auto
+
+template<typename T>
+concept lazy_value = std::same_as<T, big_integer> || std::same_as<T, rational>;
+
+template<typename E>
+concept lazy_expression = requires { typename E::value_type; } && E::is_lazy;
+
+struct lazy_add {};
+struct lazy_sub {};
+struct lazy_mul {};
+
+template<lazy_value T>
+class lazy_ref {
+public:
+	using value_type = T;
+	static constexpr bool is_lazy = true;
+
+	explicit lazy_ref(const T& x): ref(x) {}
+
+	//	верхняя граница числа лимбов результата; для rational не считается
+	size_t digits() const {
+		if constexpr (std::same_as<T, big_integer>)
+			return ref.view().size();
+		else
+			return 0;
+	}
+
+	bool refers_to(const T* p) const { return &ref == p; }
+
+	void evaluate(T& out) const { out = ref; }
+
+	//	out += (negate ? -1 : 1) * значение
+	void accumulate(T& out, bool negate) const {
+		if (negate)
+			out -= ref;
+		else
+			out += ref;
+	}
+
+	//	лист отдает ссылку на операнд без копии
+	const T& materialize(T&) const { return ref; }
+
+	void assign_to(T& out) const { out = ref; }
+
+private:
+	const T& ref;
+};
+
+//	целое слагаемое или множитель хранится по значению. Слагаемое идет через
+//	+= и -= машинного слова, множитель - через *= и addmul_small/submul_small;
+//	число из него строится, только если выражение из одного слова
+template<lazy_value T, std::integral S>
+class lazy_scalar {
+public:
+	using value_type = T;
+	static constexpr bool is_lazy = true;
+
+	explicit lazy_scalar(S x): value(x) {}
+
+	size_t digits() const {
+		if constexpr (std::same_as<T, big_integer>)
+			return 1;
+		else
+			return 0;
+	}
+
+	bool refers_to(const T*) const { return false; }
+
+	void evaluate(T& out) const {
+		out = T();
+		out += value;
+	}
+
+	void accumulate(T& out, bool negate) const {
+		if (negate)
+			out -= value;
+		else
+			out += value;
+	}
+
+	const T& materialize(T& scratch) const {
+		this->evaluate(scratch);
+		return scratch;
+	}
+
+	void assign_to(T& out) const { this->evaluate(out); }
+
+	void multiply(T& out) const { out *= value; }
+
+	//	out += (negate ? -1 : 1) * x * значение
+	void accumulate_product(T& out, const T& x, bool negate) const {
+		if constexpr (std::same_as<T, big_integer>) {
+			uint64_t m = static_cast<uint64_t>(value);
+			if constexpr (std::is_signed_v<S>) {
+				if (value < 0) {
+					m = 0 - m;
+					negate = !negate;
+				}
+			}
+			if (negate)
+				out.submul_small(x, m);
+			else
+				out.addmul_small(x, m);
+		}
+		else {
+			T temp = x;
+			temp *= value;
+			if (negate)
+				out -= temp;
+			else
+				out += temp;
+		}
+	}
+
+private:
+	S value;
+};
+
+template<typename E>
+inline constexpr bool is_lazy_scalar = false;
+
+template<lazy_value T, std::integral S>
+inline constexpr bool is_lazy_scalar<lazy_scalar<T, S>> = true;
+
+template<typename Op, lazy_expression L, lazy_expression R>
+	requires std::same_as<typename L::value_type, typename R::value_type>
+class lazy_node {
+public:
+	using value_type = typename L::value_type;
+	static constexpr bool is_lazy = true;
+
+	lazy_node(const L& l, const R& r): left(l), right(r) {}
+
+	size_t digits() const {
+		if constexpr (std::same_as<Op, lazy_mul>)
+			return left.digits() + right.digits();
+		else
+			return std::max(left.digits(), right.digits()) + 1;
+	}
+
+	bool refers_to(const value_type* p) const { return left.refers_to(p) || right.refers_to(p); }
+
+	void evaluate(value_type& out) const {
+		if constexpr (std::same_as<Op, lazy_mul> && is_lazy_scalar<R>) {
+			left.evaluate(out);
+			right.multiply(out);
+		}
+		else if constexpr (std::same_as<Op, lazy_mul> && is_lazy_scalar<L>) {
+			right.evaluate(out);
+			left.multiply(out);
+		}
+		else if constexpr (std::same_as<Op, lazy_mul>) {
+			value_type leftTemp, rightTemp;
+			const value_type& x = left.materialize(leftTemp);
+			const value_type& y = right.materialize(rightTemp);
+			out = x;
+			out *= y;
+		}
+		else {
+			left.evaluate(out);
+			right.accumulate(out, std::same_as<Op, lazy_sub>);
+		}
+	}
+
+	void accumulate(value_type& out, bool negate) const {
+		if constexpr (std::same_as<Op, lazy_mul> && is_lazy_scalar<R>) {
+			value_type temp;
+			right.accumulate_product(out, left.materialize(temp), negate);
+		}
+		else if constexpr (std::same_as<Op, lazy_mul> && is_lazy_scalar<L>) {
+			value_type temp;
+			left.accumulate_product(out, right.materialize(temp), negate);
+		}
+		else if constexpr (std::same_as<Op, lazy_mul>) {
+			value_type leftTemp, rightTemp;
+			const value_type& x = left.materialize(leftTemp);
+			const value_type& y = right.materialize(rightTemp);
+			if constexpr (std::same_as<value_type, big_integer>) {
+				if (negate)
+					out.submul(x, y);
+				else
+					out.addmul(x, y);
+			}
+			else {
+				value_type temp = x;
+				temp *= y;
+				if (negate)
+					out -= temp;
+				else
+					out += temp;
+			}
+		}
+		else {
+			left.accumulate(out, negate);
+			right.accumulate(out, negate != std::same_as<Op, lazy_sub>);
+		}
+	}
+
+	const value_type& materialize(value_type& scratch) const {
+		this->evaluate(scratch);
+		return scratch;
+	}
+
+	//	если результат сам входит в выражение, считается во временное число
+	void assign_to(value_type& out) const {
+		if (this->refers_to(&out)) {
+			value_type temp;
+			this->assign_to(temp);
+			out = std::move(temp);
+			return;
+		}
+		if constexpr (std::same_as<value_type, big_integer>)
+			out.reserve(this->digits() + 1);
+		this->evaluate(out);
+	}
+
+private:
+	L left;
+	R right;
+};
+
+template<lazy_value T>
+lazy_ref<T> lazy(const T& x) {
+	return lazy_ref<T>(x);
+}
+
+template<lazy_expression L, lazy_expression R>
+	requires std::same_as<typename L::value_type, typename R::value_type>
+lazy_node<lazy_add, L, R> operator+(const L& l, const R& r) {
+	return lazy_node<lazy_add, L, R>(l, r);
+}
+
+template<lazy_expression L, typename T = typename L::value_type>
+lazy_node<lazy_add, L, lazy_ref<T>> operator+(const L& l, const std::type_identity_t<T>& r) {
+	return lazy_node<lazy_add, L, lazy_ref<T>>(l, lazy_ref<T>(r));
+}
+
+template<lazy_expression R, typename T = typename R::value_type>
+lazy_node<lazy_add, lazy_ref<T>, R> operator+(const std::type_identity_t<T>& l, const R& r) {
+	return lazy_node<lazy_add, lazy_ref<T>, R>(lazy_ref<T>(l), r);
+}
+
+template<lazy_expression L, std::integral S>
+lazy_node<lazy_add, L, lazy_scalar<typename L::value_type, S>> operator+(const L& l, S r) {
+	return lazy_node<lazy_add, L, lazy_scalar<typename L::value_type, S>>(l, lazy_scalar<typename L::value_type, S>(r));
+}
+
+template<lazy_expression R, std::integral S>
+lazy_node<lazy_add, lazy_scalar<typename R::value_type, S>, R> operator+(S l, const R& r) {
+	return lazy_node<lazy_add, lazy_scalar<typename R::value_type, S>, R>(lazy_scalar<typename R::value_type, S>(l), r);
+}
+
+template<lazy_expression L, lazy_expression R>
+	requires std::same_as<typename L::value_type, typename R::value_type>
+lazy_node<lazy_sub, L, R> operator-(const L& l, const R& r) {
+	return lazy_node<lazy_sub, L, R>(l, r);
+}
+
+template<lazy_expression L, typename T = typename L::value_type>
+lazy_node<lazy_sub, L, lazy_ref<T>> operator-(const L& l, const std::type_identity_t<T>& r) {
+	return lazy_node<lazy_sub, L, lazy_ref<T>>(l, lazy_ref<T>(r));
+}
+
+template<lazy_expression R, typename T = typename R::value_type>
+lazy_node<lazy_sub, lazy_ref<T>, R> operator-(const std::type_identity_t<T>& l, const R& r) {
+	return lazy_node<lazy_sub, lazy_ref<T>, R>(lazy_ref<T>(l), r);
+}
+
+template<lazy_expression L, std::integral S>
+lazy_node<lazy_sub, L, lazy_scalar<typename L::value_type, S>> operator-(const L& l, S r) {
+	return lazy_node<lazy_sub, L, lazy_scalar<typename L::value_type, S>>(l, lazy_scalar<typename L::value_type, S>(r));
+}
+
+template<lazy_expression R, std::integral S>
+lazy_node<lazy_sub, lazy_scalar<typename R::value_type, S>, R> operator-(S l, const R& r) {
+	return lazy_node<lazy_sub, lazy_scalar<typename R::value_type, S>, R>(lazy_scalar<typename R::value_type, S>(l), r);
+}
+
+template<lazy_expression L, lazy_expression R>
+	requires std::same_as<typename L::value_type, typename R::value_type>
+lazy_node<lazy_mul, L, R> operator*(const L& l, const R& r) {
+	return lazy_node<lazy_mul, L, R>(l, r);
+}
+
+template<lazy_expression L, typename T = typename L::value_type>
+lazy_node<lazy_mul, L, lazy_ref<T>> operator*(const L& l, const std::type_identity_t<T>& r) {
+	return lazy_node<lazy_mul, L, lazy_ref<T>>(l, lazy_ref<T>(r));
+}
+
+template<lazy_expression R, typename T = typename R::value_type>
+lazy_node<lazy_mul, lazy_ref<T>, R> operator*(const std::type_identity_t<T>& l, const R& r) {
+	return lazy_node<lazy_mul, lazy_ref<T>, R>(lazy_ref<T>(l), r);
+}
+
+template<lazy_expression L, std::integral S>
+lazy_node<lazy_mul, L, lazy_scalar<typename L::value_type, S>> operator*(const L& l, S r) {
+	return lazy_node<lazy_mul, L, lazy_scalar<typename L::value_type, S>>(l, lazy_scalar<typename L::value_type, S>(r));
+}
+
+template<lazy_expression R, std::integral S>
+lazy_node<lazy_mul, lazy_scalar<typename R::value_type, S>, R> operator*(S l, const R& r) {
+	return lazy_node<lazy_mul, lazy_scalar<typename R::value_type, S>, R>(lazy_scalar<typename R::value_type, S>(l), r);
+}
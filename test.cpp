@@ -2,16 +2,21 @@
 
 #include <algorithm>
 #include <cstdlib>
+#include <cstring>
+#include <iomanip>
 #include <iostream>
 #include <limits>
 #include <random>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <time.h>
 
 #include "gtest/gtest.h"
 
 //#include "big_integer.h"
 #include "../big_integer.h"
+#include "../Big_integer_Rational_lazy.h"
 
 
 
@@ -53,6 +58,21 @@ TEST(correctness, from_double) {
     }
 }
 
+TEST(correctness, to_double_long) {
+    EXPECT_DOUBLE_EQ(1e20, static_cast<double>(big_integer("100000000000000000000")));
+    EXPECT_DOUBLE_EQ(-1.234567890123456e30,
+        static_cast<double>(big_integer("-1234567890123456000000000000000")));
+    EXPECT_DOUBLE_EQ(1234567890123456.0, static_cast<double>(big_integer("1234567890123456")));
+}
+
+TEST(correctness, round_digits) {
+    EXPECT_EQ(big_integer(123), big_integer(12345).round(3));
+    EXPECT_EQ(big_integer(124), big_integer(12355).round(3));
+    EXPECT_EQ(big_integer(12345), big_integer(12345).round(5));
+    EXPECT_EQ(big_integer(12345), big_integer(12345).round(8));
+    EXPECT_EQ(big_integer(987), big_integer(-987).round(3));
+}
+
 TEST(correctness, two_plus_two) {
     EXPECT_EQ(big_integer(4), big_integer(2) + big_integer(2));
     EXPECT_EQ(4, big_integer(2) + 2); // implicit conversion from int must work
@@ -447,6 +467,851 @@ TEST(correctness, mul_long_pow2) {
     EXPECT_EQ(c, b * b);
 }
 
+TEST(correctness, mul_limb_boundaries) {
+    big_integer a("99999999999999999999");
+    big_integer b("123456789012345678901234567");
+    EXPECT_EQ(big_integer("9999999999999999999800000000000000000001"), a * a);
+    EXPECT_EQ(big_integer("12345678901234567889999999910987654321098765433"), a * b);
+    EXPECT_EQ(rational("0.0025"), rational("0.05") * rational("0.05"));
+
+    big_integer top("18446744073709551615");
+    EXPECT_EQ(big_integer("340282366920938463426481119284349108225"), top * top);
+    EXPECT_EQ(big_integer("18446744073709551616"), top + 1);
+    EXPECT_EQ(top, big_integer("18446744073709551616") - 1);
+    EXPECT_EQ(big_integer("-18446744073709551616"), -top - 1);
+}
+
+TEST(correctness, mul_karatsuba) {
+    big_integer a(std::string(600, '9'));
+    big_integer b(std::string(1000, '9'));
+    big_integer c(std::string(300, '9'));
+
+    EXPECT_EQ(big_integer(std::string(599, '9') + "8" + std::string(599, '0') + "1"), a * a);
+    EXPECT_EQ(big_integer(std::string(299, '9') + "8" + std::string(700, '9') + std::string(299, '0') + "1"), b * c);
+    EXPECT_EQ(-(b * c), c * -b);
+}
+
+TEST(correctness, mul_toom3) {
+    std::string high, low;
+    for (int i = 0; i < 200; ++i) {
+        high += "98765432109";
+        low += "1234567890123";
+    }
+    big_integer a(high + low);
+    big_integer b(low + high);
+    big_integer shift("1" + std::string(low.size(), '0'));
+
+    EXPECT_EQ(big_integer(high) * b * shift + big_integer(low) * b, a * b);
+    EXPECT_EQ(big_integer(std::string(2499, '9') + "8" + std::string(500, '9') + std::string(2499, '0') + "1"),
+        big_integer(std::string(3000, '9')) * big_integer(std::string(2500, '9')));
+}
+
+TEST(correctness, mul_ntt) {
+    std::string high, low;
+    for (int i = 0; i < 7000; ++i) {
+        high += "98765432109";
+        low += "1234567890123";
+    }
+    big_integer a(high + low);
+    big_integer b(low + high);
+    big_integer shift("1" + std::string(low.size(), '0'));
+
+    EXPECT_EQ(big_integer(high) * b * shift + big_integer(low) * b, a * b);
+    EXPECT_EQ(big_integer(std::string(29999, '9') + "8" + std::string(29999, '0') + "1"),
+        big_integer(std::string(30000, '9')) * big_integer(std::string(30000, '9')));
+}
+
+TEST(correctness, square) {
+    big_integer a(-12345);
+    a.square();
+    EXPECT_EQ(152399025, a);
+
+    for (size_t n : { 20, 400, 3000, 30000, 170000 }) {
+        big_integer b(std::string(n, '9'));
+        big_integer c = b;
+        b *= b;
+        EXPECT_EQ(big_integer(std::string(n - 1, '9') + "8" + std::string(n - 1, '0') + "1"), b);
+        EXPECT_EQ(b, c * big_integer(c));
+    }
+}
+
+TEST(correctness, div_knuth) {
+    big_integer a(std::string(2000, '9'));
+    big_integer b(std::string(700, '9'));
+    big_integer q("1" + std::string(699, '0') + "1" + std::string(600, '0'));
+    big_integer r(std::string(600, '9'));
+
+    EXPECT_EQ(q, a / b);
+    EXPECT_EQ(r, a % b);
+    EXPECT_EQ(-q, -a / b);
+    EXPECT_EQ(-r, -a % b);
+    EXPECT_EQ(a, q * b + r);
+    EXPECT_EQ(0, b / a);
+    EXPECT_EQ(b, b % a);
+}
+
+TEST(correctness, divmod) {
+    big_integer a("-123456789012345678901234567890");
+    big_integer b("987654321");
+    big_integer q, r;
+    a.divmod(b, q, r);
+
+    EXPECT_EQ(a / b, q);
+    EXPECT_EQ(a % b, r);
+    EXPECT_EQ(a, q * b + r);
+
+    auto [q2, r2] = b.divmod(a);
+    EXPECT_EQ(0, q2);
+    EXPECT_EQ(b, r2);
+
+    a.divmod(b, a, b);
+    EXPECT_EQ(q, a);
+    EXPECT_EQ(r, b);
+    EXPECT_THROW(a.divmod(0), std::invalid_argument);
+}
+
+TEST(correctness, div_burnikel) {
+    big_integer a(std::string(12000, '9'));
+    big_integer b(std::string(5000, '9'));
+
+    EXPECT_EQ(big_integer("1" + std::string(4999, '0') + "1" + std::string(2000, '0')), a / b);
+    EXPECT_EQ(big_integer(std::string(2000, '9')), a % b);
+
+    std::string digits;
+    for (int i = 0; i < 1000; ++i)
+        digits += "31415926535";
+    big_integer c(digits);
+    big_integer d(digits.substr(0, 4321) + "7");
+    auto [q, r] = c.divmod(d);
+    EXPECT_EQ(c, q * d + r);
+    EXPECT_TRUE(r >= 0 && r < d);
+}
+
+TEST(correctness, div_small) {
+    big_integer a("-123456789012345678901234567890");
+
+    EXPECT_EQ(big_integer("-12345678901234567890123456789"), a / 10);
+    EXPECT_EQ(0, a % 10);
+    EXPECT_EQ(big_integer("17636684144620811271604938270"), a / -7);
+    EXPECT_EQ(0, a % 7);
+    EXPECT_EQ(big_integer("-123456789012345678901"), a / 1'000'000'000u);
+    EXPECT_EQ(-234567890, a % 1'000'000'000LL);
+    EXPECT_EQ(a / big_integer(std::numeric_limits<uint64_t>::max()), a / std::numeric_limits<uint64_t>::max());
+    EXPECT_THROW(a /= 0, std::invalid_argument);
+    EXPECT_THROW(a % 0, std::invalid_argument);
+
+    big_integer g("-" + std::string(300, '8') + "1");
+    big_integer h = g;
+    EXPECT_EQ(g % big_integer(1'000'003), g % 1'000'003);
+    EXPECT_EQ(g % big_integer(-97), g % -97);
+    EXPECT_EQ(h, g);
+
+    big_integer b = 1'000'000'007;
+    EXPECT_EQ(7u, b.divmod_small(10));
+    EXPECT_EQ(100'000'000, b);
+
+    big_integer c("-123456789012345678901234567890123456789");
+    EXPECT_EQ(558601170425184219u, c.divmod_small(std::numeric_limits<uint64_t>::max()));
+    EXPECT_EQ(big_integer("-6692605942763486918"), c);
+    big_integer e("123456789012345678901234567890123456789");
+    EXPECT_EQ(4814815581481481622u, e.divmod_small(10'000'000'000'000'000'007u));
+    EXPECT_EQ(big_integer("12345678901234567881"), e);
+    big_integer f = 5;
+    EXPECT_EQ(5u, f.divmod_small(100'000'000'000u));
+    EXPECT_EQ(f, 0);
+}
+
+TEST(correctness, modulus_context) {
+    big_integer m("1000000000000000000000000000057");
+    big_integer::modulus_context odd(m);
+    big_integer::modulus_context even(big_integer("1000000000000000000"));
+
+    EXPECT_EQ(big_integer("841934383925717112980682223332"), odd.pow(2, big_integer("100000000000000000000")));
+    EXPECT_EQ(big_integer("922883132974933589"), even.pow(123456789, 987654321));
+    EXPECT_EQ(big_integer("-249657064154244780363023929426"),
+        odd.mul(big_integer("-12345678901234567890123456789"), big_integer("98765432109876543210")));
+    EXPECT_EQ(big_integer("-12345678901234567890") % m, odd.reduce(big_integer("-12345678901234567890")));
+    EXPECT_EQ(big_integer("98765432109876543210987654321098765") % m, odd.reduce(big_integer("98765432109876543210987654321098765")));
+    EXPECT_THROW(big_integer::modulus_context(0), std::invalid_argument);
+
+    //	длинный модуль: обратная считается итерациями Ньютона
+    big_integer wide(std::string(10'000, '7'));
+    wide += 2;
+    big_integer::modulus_context reciprocal(wide);
+    for (const big_integer& a : { wide * wide - 1, -(wide * (wide - 5) + 12345), wide - 1, wide * 3 }) {
+        auto [q, r] = reciprocal.divmod(a);
+        auto [q2, r2] = a.divmod(wide);
+        EXPECT_EQ(q2, q);
+        EXPECT_EQ(r2, r);
+    }
+}
+
+TEST(correctness, three_way_compare) {
+    big_integer a("123456789012345678901234567890");
+    big_integer b("-123456789012345678901234567890");
+    big_integer c("123456789012345678901234567891");
+
+    EXPECT_TRUE((a <=> c) < 0);
+    EXPECT_TRUE((c <=> a) > 0);
+    EXPECT_TRUE((a <=> a) == 0);
+    EXPECT_TRUE((b <=> a) < 0);
+    EXPECT_TRUE(b < a);
+    EXPECT_TRUE(-c < b);
+    EXPECT_TRUE(a <= c);
+    EXPECT_TRUE(c >= a);
+    EXPECT_TRUE(big_integer(0) == -big_integer(0));
+    EXPECT_TRUE(big_integer(-5) < big_integer(0));
+    EXPECT_TRUE(big_integer(-5) > big_integer(-6));
+    EXPECT_TRUE(big_integer(100) > big_integer(99));
+    EXPECT_FALSE(bool(big_integer(0)));
+    EXPECT_FALSE(bool(big_integer(-3)));
+    EXPECT_TRUE(bool(big_integer(3)));
+    EXPECT_EQ(a + b, 0);
+    EXPECT_EQ(a - c, -1);
+    EXPECT_EQ(b + c, 1);
+}
+
+TEST(correctness, view) {
+    big_integer a("-98765432109876543210");
+    big_integer b("12345678901234567890");
+    big_integer_view va = a.view();
+
+    EXPECT_EQ(va.size(), 2);
+    EXPECT_FALSE(va.getSign());
+    EXPECT_TRUE(va.abs().getSign());
+    EXPECT_TRUE(va < b.view());
+    EXPECT_TRUE(va.abs() > b.view());
+    EXPECT_TRUE(-va == big_integer("98765432109876543210").view());
+    EXPECT_TRUE(big_integer(0).view().isZero());
+    EXPECT_TRUE(big_integer(0).view() == (-big_integer(0)).view());
+
+    b += a.view().abs();
+    EXPECT_EQ(b, big_integer("111111111011111111100"));
+    b -= a.view().abs();
+    EXPECT_EQ(b, big_integer("12345678901234567890"));
+
+    a += a.view();
+    EXPECT_EQ(a, big_integer("-197530864219753086420"));
+    a -= a.view();
+    EXPECT_EQ(a, 0);
+
+    big_integer c("999999999999");
+    c += c;
+    EXPECT_EQ(c, big_integer("1999999999998"));
+    c -= -c;
+    EXPECT_EQ(c, big_integer("3999999999996"));
+}
+
+TEST(correctness, view_self_alias) {
+    big_integer a = -5;
+    a += a.view().abs();
+    EXPECT_EQ(a, 0);
+
+    big_integer b = 7;
+    b -= -b.view();
+    EXPECT_EQ(b, 14);
+
+    big_integer c = 7;
+    c += -c.view();
+    EXPECT_EQ(c, 0);
+
+    big_integer d("-123456789012345678901234567890");
+    d -= d.view().abs();
+    EXPECT_EQ(d, big_integer("-246913578024691357802469135780"));
+    EXPECT_EQ(big_integer(-d.view()), big_integer("246913578024691357802469135780"));
+}
+
+TEST(correctness, move) {
+    big_integer a("123456789012345678901234567890");
+    big_integer b(std::move(a));
+    EXPECT_EQ(b, big_integer("123456789012345678901234567890"));
+
+    a = std::move(b);
+    EXPECT_EQ(a, big_integer("123456789012345678901234567890"));
+    b = a;
+    a.swap(b);
+    EXPECT_EQ(a, b);
+
+    big_integer c = -1;
+    c.swap(a);
+    EXPECT_EQ(c, big_integer("123456789012345678901234567890"));
+    EXPECT_EQ(a, -1);
+
+    EXPECT_EQ(big_integer(5) + c, big_integer("123456789012345678901234567895"));
+    EXPECT_EQ(c + big_integer(5), big_integer("123456789012345678901234567895"));
+    EXPECT_EQ(big_integer(5) - c, big_integer("-123456789012345678901234567885"));
+    EXPECT_EQ(big_integer(-2) * c, big_integer("-246913578024691357802469135780"));
+    EXPECT_EQ(c * big_integer(-2), big_integer("-246913578024691357802469135780"));
+    EXPECT_EQ(big_integer(3) * big_integer(4) + big_integer(5), 17);
+
+    rational r("1.5");
+    rational s(std::move(r));
+    r = std::move(s);
+    EXPECT_EQ(r, rational("1.5"));
+    EXPECT_EQ(rational("0.25") + r, rational("1.75"));
+    EXPECT_EQ(r * rational("2"), rational("3"));
+    EXPECT_EQ(rational("3") / r, rational("2"));
+    EXPECT_EQ(rational("2.75") - r, rational("1.25"));
+}
+
+TEST(correctness, moved_from_is_zero) {
+    big_integer a("123456789012345678901234567890123456789012345678901234567890");
+    big_integer b(std::move(a));
+    EXPECT_EQ(a, 0);
+    EXPECT_EQ(a.to_string(), "0");
+    EXPECT_TRUE(a.view().isZero());
+    a += 5;
+    EXPECT_EQ(a, 5);
+
+    big_integer c = -42;
+    c = std::move(b);
+    EXPECT_EQ(b, 0);
+    EXPECT_EQ(b.to_string(), "0");
+    EXPECT_EQ(b - 1, -1);
+
+    rational r("-12.75");
+    rational s(std::move(r));
+    EXPECT_EQ(r, 0);
+    EXPECT_EQ(r.to_string(), rational(0).to_string());
+    rational t = 3;
+    t = std::move(s);
+    EXPECT_EQ(s, 0);
+    EXPECT_EQ(s + rational("1.5"), rational("1.5"));
+    std::ostringstream out;
+    out << s;
+    EXPECT_EQ(out.str(), "0");
+}
+
+TEST(correctness, inline_storage) {
+    digit_buffer d;
+    EXPECT_TRUE(d.isInline());
+    for (int i = 0; i < 100; ++i)
+        d.push_back(static_cast<uint64_t>(i % 10));
+    EXPECT_FALSE(d.isInline());
+    EXPECT_EQ(d.size(), 100);
+    EXPECT_EQ(d[57], 7);
+    d.erase(d.begin() + 3, d.end());
+    d.shrink_to_fit();
+    EXPECT_TRUE(d.isInline());
+    EXPECT_EQ(d.back(), 2);
+    d.insert(d.begin(), 45, 0);
+    EXPECT_FALSE(d.isInline());
+    EXPECT_EQ(d.size(), 48);
+    EXPECT_EQ(d[45], 0);
+    EXPECT_EQ(d[46], 1);
+
+    digit_buffer e;
+    e.push_back(3);
+    e.swap(d);
+    EXPECT_EQ(d.size(), 1);
+    EXPECT_EQ(e.size(), 48);
+    digit_buffer f(std::move(e));
+    EXPECT_EQ(f[47], 2);
+    EXPECT_EQ(e.size(), 0);
+
+    big_integer a("9999999999999999999999999999999999999999");
+    big_integer b("12345678901234567890");
+    EXPECT_EQ(a * b, big_integer("123456789012345678899999999999999999999987654321098765432110"));
+    EXPECT_EQ(a / b, big_integer("810000007290000066347"));
+    EXPECT_EQ(a % b, big_integer("1242021690124202169"));
+    EXPECT_EQ(a / big_integer("123456789012345"), big_integer("81000000729000452061008078"));
+    EXPECT_EQ(-a % big_integer("123456789012345"), big_integer("-6365313277089"));
+    EXPECT_EQ(big_integer("18446744073709551615") / big_integer(-3), big_integer("-6148914691236517205"));
+    EXPECT_EQ((a + 1) - a, 1);
+}
+
+TEST(correctness, memory_resource) {
+    big_integer expected = 1;
+    for (int i = 2; i <= 200; ++i)
+        expected *= i;
+
+    digit_arena arena;
+    digit_pool_resource pool(&arena);
+    big_integer result(std::pmr::new_delete_resource());
+    {
+        digit_resource_scope scope(&pool);
+        big_integer f = 1;
+        for (int i = 2; i <= 200; ++i)
+            f *= i;
+        EXPECT_EQ(f.get_resource(), &pool);
+        EXPECT_EQ(f, expected);
+        EXPECT_EQ(f / expected, 1);
+        result = f;
+    }
+    EXPECT_EQ(result.get_resource(), std::pmr::new_delete_resource());
+    pool.release();
+    arena.release();
+    EXPECT_EQ(result, expected);
+
+    void* p = pool.allocate(100, 1);
+    pool.deallocate(p, 100, 1);
+    EXPECT_EQ(pool.allocate(120, 1), p);
+
+    big_integer a(expected, &pool);
+    big_integer b = a;
+    EXPECT_EQ(b.get_resource(), std::pmr::get_default_resource());
+    big_integer c(expected, &arena);
+    a = std::move(c);
+    EXPECT_EQ(a.get_resource(), &pool);
+    EXPECT_EQ(a, expected);
+    b.swap(a);
+    EXPECT_EQ(b.get_resource(), &pool);
+    EXPECT_EQ(a.get_resource(), std::pmr::get_default_resource());
+
+    rational r(rational("12.5"), &pool);
+    EXPECT_EQ(r.get_resource(), &pool);
+    EXPECT_EQ(r * 2, rational("25"));
+}
+
+TEST(correctness, memory_resource_scope_is_per_thread) {
+    big_integer expected = big_integer(std::string(300, '9')) * big_integer(std::string(300, '7'));
+    big_integer copy;
+    {
+        digit_arena arena;
+        big_integer source(expected, &arena);
+        copy = big_integer(source);
+        EXPECT_EQ(copy.get_resource(), std::pmr::get_default_resource());
+        rational fraction(rational("1.25"), &arena);
+        rational fractionCopy = fraction;
+        EXPECT_EQ(fractionCopy.get_resource(), std::pmr::get_default_resource());
+        arena.release();
+    }
+    EXPECT_EQ(copy, expected);
+
+    digit_pool_resource pool;
+    {
+        digit_resource_scope scope(&pool);
+        EXPECT_EQ(digit_resource_scope::current(), &pool);
+        EXPECT_EQ(big_integer().get_resource(), &pool);
+        std::pmr::memory_resource* other = nullptr;
+        std::thread([&] {
+            other = big_integer(expected).get_resource();
+        }).join();
+        EXPECT_EQ(other, std::pmr::get_default_resource());
+        EXPECT_EQ(std::pmr::get_default_resource(), std::pmr::new_delete_resource());
+    }
+    EXPECT_EQ(digit_resource_scope::current(), std::pmr::get_default_resource());
+}
+
+TEST(correctness, workspace) {
+    big_integer a(std::string(2000, '7'));
+    big_integer b(std::string(700, '3'));
+    big_integer expected = a * b / (b + 1);
+
+    {
+        big_integer::workspace ws;
+        EXPECT_EQ(ws.cached(), 0);
+        for (int i = 0; i < 3; ++i)
+            EXPECT_EQ(a * b / (b + 1), expected);
+        EXPECT_TRUE(ws.cached() > 0);
+        {
+            big_integer::workspace inner;
+            EXPECT_EQ(a * b / (b + 1), expected);
+            EXPECT_TRUE(inner.cached() > 0);
+        }
+        ws.release();
+        EXPECT_EQ(ws.cached(), 0);
+    }
+    EXPECT_EQ(a * b / (b + 1), expected);
+    EXPECT_EQ(a % b, a - a / b * b);
+}
+
+TEST(correctness, addmul) {
+    big_integer a("123456789012345678901234567890123456789012345678901234567890");
+    big_integer b("-98765432109876543210987654321");
+    big_integer acc("1000000000000000000000000000000000000000000000000000000000000000000000000000000000000000");
+
+    big_integer x = acc;
+    x.addmul(a, b);
+    EXPECT_EQ(x, acc + a * b);
+    x.submul(a, b);
+    EXPECT_EQ(x, acc);
+    x.submul(b, b);
+    EXPECT_EQ(x, acc - b * b);
+
+    big_integer y = 5;
+    y.submul(a, a);
+    EXPECT_EQ(y, 5 - a * a);
+    y.addmul(a, a);
+    EXPECT_EQ(y, 5);
+
+    big_integer z = 0;
+    z.addmul_small(b, 18446744073709551615ull);
+    EXPECT_EQ(z, big_integer("-1821900649460228180098750659508053165301527278415"));
+    z.addmul_small(b, 0);
+    z.addmul_small(-b, 18446744073709551615ull);
+    EXPECT_EQ(z, 0);
+    z.submul_small(b, 3);
+    EXPECT_EQ(z, -3 * b);
+    z.submul_small(z, 2);
+    EXPECT_EQ(z, 3 * b);
+
+    big_integer w = 7;
+    w.addmul(w, w);
+    EXPECT_EQ(w, 56);
+    w.submul(big_integer(8), big_integer(7));
+    EXPECT_EQ(w, 0);
+}
+
+TEST(correctness, lazy_expression) {
+    big_integer a("123456789012345678901234567890");
+    big_integer b("-98765432109876543210");
+    big_integer c("55555555555555555555555555555555555555555555");
+    big_integer d("7");
+    big_integer e("1000000000000000000000000000000000000000000000000000000");
+
+    big_integer r = lazy(a) * b + lazy(c) * d - e;
+    EXPECT_EQ(r, a * b + c * d - e);
+
+    r = lazy(a) - b * lazy(c) + d;
+    EXPECT_EQ(r, a - b * c + d);
+
+    r = lazy(a) * (lazy(b) + c) * d;
+    EXPECT_EQ(r, a * (b + c) * d);
+
+    r = lazy(r) * r - r;
+    EXPECT_EQ(r, a * (b + c) * d * (a * (b + c) * d) - a * (b + c) * d);
+
+    big_integer s = lazy(a);
+    EXPECT_EQ(s, a);
+    s = e - lazy(e);
+    EXPECT_EQ(s, 0);
+
+    r = lazy(a) * 3 - lazy(c) * -5 + 7 * lazy(b) - std::numeric_limits<int64_t>::min() * lazy(d);
+    EXPECT_EQ(r, a * 3 + c * 5 + b * 7 - big_integer(std::numeric_limits<int64_t>::min()) * d);
+    r = (lazy(a) + b) * -2u;
+    EXPECT_EQ(r, (a + b) * -2u);
+    r = 0 * lazy(e) - lazy(a) * 0;
+    EXPECT_EQ(r, 0);
+
+    rational x("1.5"), y("2.25"), z("-3");
+    rational t = lazy(x) * y + z;
+    EXPECT_EQ(t, x * y + z);
+    t = lazy(x) + y - lazy(z) * x;
+    EXPECT_EQ(t, rational("8.25"));
+    t = lazy(x) * -4 + 2 * lazy(y);
+    EXPECT_EQ(t, rational("-1.5"));
+}
+
+TEST(correctness, scalar_operands) {
+    big_integer a("99999999999999999999999999999999999999999");
+    EXPECT_EQ(a + 1, big_integer("100000000000000000000000000000000000000000"));
+    EXPECT_EQ(1 - a, big_integer("-99999999999999999999999999999999999999998"));
+    EXPECT_EQ(a * -3000000000LL, big_integer("-299999999999999999999999999999999999999997000000000"));
+    EXPECT_EQ(a * UINT64_MAX, big_integer("1844674407370955161499999999999999999999981553255926290448385"));
+    EXPECT_EQ(big_integer(INT64_MIN) - INT64_MIN, 0);
+    EXPECT_TRUE(a > UINT64_MAX);
+
+    big_integer b = 5;
+    b -= 12u;
+    EXPECT_EQ(b, -7);
+    EXPECT_TRUE(b < 0 && 0 > b && b != 7 && b == -7LL);
+
+    rational x("-1.25");
+    EXPECT_EQ(x + 2, rational("0.75"));
+    EXPECT_EQ(x - 1, rational("-2.25"));
+    EXPECT_EQ(2 - x, rational("3.25"));
+    EXPECT_EQ(x * -4, 5);
+    EXPECT_EQ(x / 8, -rational("0.15625"));
+    x += 1;
+    EXPECT_EQ(x, -rational("0.25"));
+    EXPECT_TRUE(x < 0 && x > -1 && x != 0);
+}
+
+TEST(correctness, decimal_shift) {
+    big_integer a("-123456789");
+    a.shift_decimal(50);
+    EXPECT_EQ(a, big_integer("-12345678900000000000000000000000000000000000000000000000000"));
+    EXPECT_EQ(a, big_integer(-123456789) * big_integer::pow10(50));
+    a.unshift_decimal(55);
+    EXPECT_EQ(a, -1234);
+    a.unshift_decimal(10);
+    EXPECT_EQ(a, 0);
+    EXPECT_EQ(a.to_string(), "0");
+    EXPECT_EQ(a.shift_decimal(3), 0);
+    EXPECT_EQ(big_integer::pow10(0), 1);
+
+    rational x("0.005"), y("0.00500");
+    EXPECT_TRUE(x == y);
+    EXPECT_TRUE(x < rational("0.0051"));
+    EXPECT_EQ(x + rational("1.25"), rational("1.255"));
+}
+
+TEST(correctness, string_round_trip_long) {
+    std::mt19937 gen(21);
+    std::string s(1'000'000, '0');
+    for (auto& c : s)
+        c = static_cast<char>('0' + gen() % 10);
+    s[0] = '-';
+    s[1] = '9';
+
+    big_integer a(s);
+    EXPECT_EQ(a.to_string(), s);
+    std::ostringstream out;
+    out << a;
+    EXPECT_EQ(out.str(), s);
+    EXPECT_EQ(big_integer("000120").to_string(), "120");
+
+    std::ostringstream fraction;
+    fraction << rational("1.05");
+    EXPECT_EQ(fraction.str(), "1.05");
+}
+
+//	перевод не должен скатываться в квадратичный: у него вчетверо более длинное
+//	число читалось бы и писалось в 16 раз дольше. Берется лучший из трех замеров
+TEST(correctness, string_conversion_scaling) {
+    std::mt19937 gen(42);
+    auto measure = [&gen](size_t digits) {
+        std::string s(digits, '0');
+        for (auto& c : s)
+            c = static_cast<char>('0' + gen() % 10);
+        s[0] = '5';
+        double best = 1e9;
+        for (int i = 0; i < 3; ++i) {
+            clock_t start = clock();
+            big_integer a(s);
+            std::string back = a.to_string();
+            best = std::min(best, static_cast<double>(clock() - start) / CLOCKS_PER_SEC);
+            EXPECT_EQ(back, s);
+        }
+        return best;
+    };
+    double small = measure(200'000);
+    double large = measure(800'000);
+    EXPECT_LT(large, 12 * small);
+}
+
+TEST(correctness, stream_format) {
+    std::ostringstream out;
+    big_integer a = -1234;
+    out << std::setw(8) << a << '|' << std::setw(8) << std::left << a << '|';
+    out << std::setw(8) << std::internal << std::setfill('0') << a << '|';
+    out << std::showpos << std::setfill(' ') << std::right << std::setw(5) << big_integer(56) << '|';
+    out << std::noshowpos << std::setw(7) << -rational("0.05");
+    EXPECT_EQ(out.str(), "   -1234|-1234   |-0001234|  +56|  -0.05");
+
+    std::istringstream in("  -00123abc +77 -0.050 12.5x");
+    big_integer x, y;
+    rational r, s;
+    std::string rest;
+    in >> x >> rest >> y >> r >> s;
+    EXPECT_EQ(x, -123);
+    EXPECT_EQ(rest, "abc");
+    EXPECT_EQ(y, 77);
+    EXPECT_EQ(r, -rational("0.05"));
+    EXPECT_EQ(s, rational("12.5"));
+    EXPECT_TRUE(in.good());
+    in >> x;
+    EXPECT_TRUE(in.fail());
+    EXPECT_EQ(x, 0);
+}
+
+//	длинные числа из потока разбираются блоками, которые сливаются попарно
+TEST(correctness, stream_long_numbers) {
+    std::mt19937 gen(22);
+    std::string s(100'000, '0');
+    for (auto& c : s)
+        c = static_cast<char>('0' + gen() % 10);
+    s[0] = '8';
+    big_integer expected(s);
+
+    std::istringstream in("-" + s + "x " + s.substr(0, 5'000) + "." + s + "0 ");
+    big_integer a;
+    rational r;
+    in >> a;
+    EXPECT_EQ(a, -expected);
+    EXPECT_EQ(in.get(), 'x');
+    in >> r;
+    EXPECT_EQ(r, rational(s.substr(0, 5'000) + "." + s + "0"));
+    EXPECT_TRUE(in.good());
+
+    std::ostringstream hexOut;
+    hexOut << std::hex << std::showbase << a;
+    std::istringstream hexIn(hexOut.str());
+    big_integer h;
+    hexIn >> std::hex >> h;
+    EXPECT_EQ(h, a);
+    EXPECT_TRUE(hexIn.eof());
+
+    std::ostringstream padded;
+    padded << std::setw(100'005) << std::setfill('*') << a << '|' << std::setw(9) << std::left << rational("-1.050") << '|';
+    EXPECT_EQ(padded.str(), "****-" + s + "|-1.050***|");
+}
+
+TEST(correctness, chars_conversion) {
+    const std::string text = "-001234xyz";
+    big_integer a = 7;
+    auto [end, ec] = big_integer::from_chars(text.data(), text.data() + text.size(), a);
+    EXPECT_EQ(ec, std::errc());
+    EXPECT_EQ(end, text.data() + 7);
+    EXPECT_EQ(a, -1234);
+
+    for (const char* bad : { "", "-", "+5", "x1" }) {
+        big_integer b = 7;
+        auto result = big_integer::from_chars(bad, bad + strlen(bad), b);
+        EXPECT_EQ(result.ec, std::errc::invalid_argument);
+        EXPECT_EQ(result.ptr, bad);
+        EXPECT_EQ(b, 7);
+    }
+
+    char buffer[8];
+    auto written = big_integer::to_chars(buffer, buffer + sizeof buffer, a);
+    EXPECT_EQ(written.ec, std::errc());
+    EXPECT_EQ(std::string(buffer, written.ptr), "-1234");
+    EXPECT_EQ(big_integer::to_chars(buffer, buffer + 4, a).ec, std::errc::value_too_large);
+    written = big_integer::to_chars(buffer, buffer + 1, big_integer());
+    EXPECT_EQ(std::string(buffer, written.ptr), "0");
+
+    EXPECT_EQ(big_integer("-05"), 5);
+    EXPECT_THROW(big_integer("12 "), std::invalid_argument);
+    EXPECT_EQ(rational(std::string("12.050")).to_string(), rational("12.050").to_string());
+    EXPECT_THROW(rational("1.2.3"), std::invalid_argument);
+}
+
+//	считает выделения поверх new_delete_resource и после limit отказывает
+class counting_resource : public std::pmr::memory_resource {
+public:
+    size_t allocations = 0;
+    size_t limit = SIZE_MAX;
+
+private:
+    void* do_allocate(size_t bytes, size_t align) override {
+        if (allocations == limit)
+            throw std::bad_alloc();
+        ++allocations;
+        return std::pmr::new_delete_resource()->allocate(bytes, align);
+    }
+    void do_deallocate(void* p, size_t bytes, size_t align) override {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+//	разбор берет память только под результат и не портит value при ошибке
+TEST(correctness, chars_allocation) {
+    const std::string shortText = "-" + std::string(70, '7');
+    const std::string longText(1'000, '3');
+    const std::string hugeText(5'000, '1');
+    big_integer expected(longText);
+
+    counting_resource counter;
+    digit_resource_scope scope(&counter);
+    big_integer value(&counter);
+    auto result = big_integer::from_chars(shortText.data(), shortText.data() + shortText.size(), value);
+    EXPECT_EQ(result.ec, std::errc());
+    EXPECT_EQ(counter.allocations, 0);
+    result = big_integer::from_chars(longText.data(), longText.data() + longText.size(), value, 10);
+    EXPECT_EQ(result.ec, std::errc());
+    EXPECT_EQ(counter.allocations, 1);
+    EXPECT_EQ(value, expected);
+
+    counter.limit = counter.allocations;
+    result = big_integer::from_chars(hugeText.data(), hugeText.data() + hugeText.size(), value);
+    EXPECT_EQ(result.ec, std::errc::not_enough_memory);
+    EXPECT_EQ(result.ptr, hugeText.data());
+    counter.limit = SIZE_MAX;
+    EXPECT_EQ(value, expected);
+}
+
+TEST(correctness, chars_block_boundaries) {
+    std::mt19937 gen(24);
+    for (size_t length : { 1, 15, 16, 17, 31, 32, 33, 63, 64, 65, 100 }) {
+        std::string text(length, '0');
+        for (char& c : text)
+            c = static_cast<char>('0' + gen() % 10);
+        text[0] = static_cast<char>('1' + gen() % 9);
+        EXPECT_EQ(big_integer(text).to_string(), text);
+        EXPECT_EQ(big_integer("-" + text).to_string(), "-" + text);
+
+        for (size_t bad = 0; bad < length; ++bad) {
+            for (char c : { '/', ':', ' ', '\x80' }) {
+                std::string broken = text;
+                broken[bad] = c;
+                big_integer value;
+                auto result = big_integer::from_chars(broken.data(), broken.data() + broken.size(), value);
+                EXPECT_EQ(result.ptr, broken.data() + (bad == 0 ? 0 : bad));
+                EXPECT_THROW(big_integer{ broken }, std::invalid_argument);
+            }
+        }
+    }
+}
+
+//	каждый доступный набор ядер разбирает и пишет то же, что и скалярный
+TEST(correctness, digit_kernels_agree) {
+    std::mt19937 gen(24);
+    std::string s(5'000, '0');
+    for (auto& c : s)
+        c = static_cast<char>('0' + gen() % 10);
+    s[0] = '4';
+
+    big_integer::digit_kernels saved = big_integer::current_digit_kernels();
+    for (auto set : { big_integer::digit_kernels::scalar, big_integer::digit_kernels::sse2,
+            big_integer::digit_kernels::sse41, big_integer::digit_kernels::avx2 }) {
+        if (!big_integer::select_digit_kernels(set)) {
+            EXPECT_NE(set, big_integer::digit_kernels::scalar);
+            continue;
+        }
+        EXPECT_EQ(big_integer::current_digit_kernels(), set);
+        big_integer a(s);
+        EXPECT_EQ(a.to_string(), s);
+        EXPECT_EQ(big_integer("-" + s.substr(0, 47)).to_string(), "-" + s.substr(0, 47));
+        for (size_t stop : { 1, 15, 16, 17, 31, 32, 33, 100 }) {
+            std::string t = s.substr(0, stop) + "x" + s.substr(stop + 1, 64);
+            big_integer b;
+            auto [end, ec] = big_integer::from_chars(t.data(), t.data() + t.size(), b);
+            EXPECT_EQ(ec, std::errc());
+            EXPECT_EQ(static_cast<size_t>(end - t.data()), stop);
+            EXPECT_EQ(b.to_string(), s.substr(0, stop));
+        }
+    }
+    EXPECT_TRUE(big_integer::select_digit_kernels(saved));
+}
+
+TEST(correctness, radix_conversion) {
+    EXPECT_EQ(big_integer("DeadBeef", 16), 3735928559LL);
+    EXPECT_EQ(big_integer("-0ff", 16), -255);
+    EXPECT_EQ(big_integer(-255).to_string(16), "-ff");
+    EXPECT_EQ(big_integer(0).to_string(2), "0");
+    EXPECT_EQ(big_integer(35).to_string(36), "z");
+    EXPECT_THROW(big_integer("0x10", 16), std::invalid_argument);
+    EXPECT_THROW(big_integer("19", 8), std::invalid_argument);
+    EXPECT_THROW(big_integer(1).to_string(37), std::invalid_argument);
+
+    std::string text(3000, '0');
+    std::mt19937 gen(25);
+    for (char& c : text)
+        c = static_cast<char>('0' + gen() % 10);
+    text[0] = '7';
+    big_integer a(text);
+    for (int base : { 2, 7, 16, 36 })
+        EXPECT_EQ(big_integer(a.to_string(base), base), a);
+
+    char buffer[4];
+    auto written = big_integer::to_chars(buffer, buffer + sizeof buffer, big_integer(-255), 16);
+    EXPECT_EQ(std::string(buffer, written.ptr), "-ff");
+    EXPECT_EQ(big_integer::to_chars(buffer, buffer + 2, big_integer(-255), 16).ec, std::errc::value_too_large);
+
+    std::ostringstream out;
+    out << std::hex << std::showbase << big_integer(3735928559LL) << ' ' << std::uppercase << big_integer(-255) << ' ';
+    out << std::oct << big_integer(8) << ' ' << big_integer(0) << ' ' << std::noshowbase << std::nouppercase;
+    out << std::hex << std::setw(6) << std::internal << std::setfill('0') << big_integer(-255);
+    EXPECT_EQ(out.str(), "0xdeadbeef -0XFF 010 0 -000ff");
+
+    std::istringstream in("0xff -1A zz 777");
+    big_integer x, y;
+    in >> std::hex >> x >> y;
+    EXPECT_EQ(x, 255);
+    EXPECT_EQ(y, -26);
+    in >> x;
+    EXPECT_TRUE(in.fail());
+    in.clear();
+    std::string rest;
+    in >> rest >> std::oct >> x;
+    EXPECT_EQ(x, 511);
+}
+
 TEST(correctness, div_0_long) {
     big_integer a;
     big_integer b("100000000000000000000000000000000000000000000000000000000000");
@@ -480,6 +1345,12 @@ TEST(correctness, div_long_signed2) {
     EXPECT_EQ(c, a / b);
 }
 
+TEST(correctness, div_inner_zeros) {
+    EXPECT_EQ(big_integer("10000000000"), big_integer("10000000000555") / big_integer("1000"));
+    EXPECT_EQ(big_integer("1005"), big_integer("100555") / big_integer("100"));
+    EXPECT_EQ(big_integer("-200000000001"), big_integer("-600000000003999") / big_integer("3000"));
+}
+
 TEST(correctness, negation_long) {
     big_integer a("10000000000000000000000000000000000000000000000000000");
     big_integer c("-10000000000000000000000000000000000000000000000000000");
@@ -936,6 +1807,20 @@ TEST(correctness, sub_signed_rational) {
     EXPECT_EQ(a, 85.3);
 }
 
+TEST(correctness, rational_equality_fraction_length) {
+    EXPECT_TRUE(rational("0.25") == rational("0.250"));
+    EXPECT_TRUE(rational("0.250") == rational("0.25"));
+    EXPECT_FALSE(rational("0.25") == rational("0.5"));
+    EXPECT_FALSE(rational("1.5") == rational("1.25"));
+    EXPECT_EQ(rational("0.25") + rational("1.5"), rational("1.75"));
+    EXPECT_EQ(rational("1.5") + rational("0.25"), rational("1.75"));
+}
+
+TEST(correctness, sub_rational_equal_fraction) {
+    EXPECT_EQ(rational("35") - rational("9001"), rational("-8966"));
+    EXPECT_EQ(rational("1.5") - rational("2.5"), rational(-1));
+}
+
 double round_(double d, size_t count) {
     for (size_t i = 0; i < count; ++i) {
         d *= 10;
@@ -1023,7 +1908,7 @@ TEST(correctness, rational_dived_long_signed) {
     rational a("-1000000000000000000000000000000000000000000000000000000000000"
         "0000000000000000000000000000000.555");
     rational b("100000000000000000000000000000000000000");
-    rational c("-10000000000000000000000000000000000000000000000000000.000000000000000000000000000000000000555");
+    rational c("-100000000000000000000000000000000000000000000000000000.00000000000000000000000000000000000000555");
 
     EXPECT_EQ(c, a / b);
 }